@@ -0,0 +1,51 @@
+#pragma once
+#include <cstdint>
+
+#include "daisy.h"
+
+/**
+ * Boot phase timestamps.
+ *
+ * Mark() records daisy::System::GetUs() at the END of a phase, so a phase's
+ * duration is the difference to the previous mark. The timer only runs
+ * once System::Init() has set up the clocks, so the first mark goes right
+ * after it and everything before (reset, clock tree) is not covered.
+ *
+ * The timeline lives in RAM (TimeMachineHardware::boot) where a debugger
+ * can read it; main() prints it over the USB log in BOOT_TRACE=1 and
+ * PROFILE=1 builds.
+ */
+
+namespace oam {
+
+class BootTimeline {
+public:
+  static const int kMaxPhases = 16;
+
+  struct Phase {
+    const char *name; // string literal
+    uint32_t us;      // System::GetUs() at the end of the phase
+  };
+
+  void Mark(const char *name) {
+    if (count_ >= kMaxPhases)
+      return;
+    phases_[count_].name = name;
+    phases_[count_].us = daisy::System::GetUs();
+    count_++;
+  }
+
+  int Count() const { return count_; }
+  const Phase &Get(int i) const { return phases_[i]; }
+
+  /** Duration of phase i, the first one counts from the timer start */
+  uint32_t DurationUs(int i) const {
+    return i == 0 ? phases_[0].us : phases_[i].us - phases_[i - 1].us;
+  }
+
+private:
+  Phase phases_[kMaxPhases];
+  int count_ = 0;
+};
+
+} // namespace oam
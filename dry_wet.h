@@ -0,0 +1,36 @@
+#pragma once
+#include <cstddef>
+
+/**
+ * Dry/wet mix for the engines' output stage.
+ *
+ * Begin() once per block with the new mix; Next() per sample then ramps
+ * linearly from the last block's mix to it, so slider moves don't zipper.
+ * The first block after Reset() starts on the target.
+ */
+
+namespace oam {
+
+class DryWetRamp {
+public:
+  void Reset() { last_ = -1.0f; }
+
+  void Begin(float dry_mix, size_t size) {
+    dry_ = last_ < 0.0f ? dry_mix : last_;
+    inc_ = (dry_mix - dry_) / (float)size;
+    last_ = dry_mix;
+  }
+
+  /** Dry gain for the next sample, wet is 1 - dry */
+  float Next() {
+    dry_ += inc_;
+    return dry_;
+  }
+
+private:
+  float last_ = -1.0f;
+  float dry_ = 0.0f;
+  float inc_ = 0.0f;
+};
+
+} // namespace oam
@@ -0,0 +1,174 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#if !defined(__arm__)
+#include <chrono>
+#endif
+
+/**
+ * DSP load profiler for the audio callback.
+ *
+ * Build with `make PROFILE=1` (defines OAM_PROFILE). Without it every
+ * OAM_PROF_* macro expands to nothing and the engines compile exactly as
+ * before.
+ *
+ * Usage from the callback:
+ *   OAM_PROF_BLOCK_BEGIN();
+ *   ...engine code with OAM_PROF_MARK(oam::PROF_xxx) after each stage...
+ *   OAM_PROF_BLOCK_END();
+ *
+ * A mark charges the cycles since the previous mark (or block start) to the
+ * given stage, so marks are placed at the END of the work they measure.
+ * Each mark is one counter read, a subtract and an add (~4 cycles on the M7).
+ */
+
+namespace oam {
+
+enum ProfStage {
+  PROF_DIFFUSION,
+  PROF_DELAY_READ,
+  PROF_MATRIX,
+  PROF_FEEDBACK, // feedback, filters, shimmer, delay writes
+  PROF_MIX,      // output sum and dry/wet
+  PROF_STAGE_LAST
+};
+
+inline const char *ProfStageName(int s) {
+  static const char *names[PROF_STAGE_LAST] = {"diffusion", "delay read",
+                                               "matrix", "feedback/filter",
+                                               "dry/wet mix"};
+  return s >= 0 && s < PROF_STAGE_LAST ? names[s] : "?";
+}
+
+#if defined(__arm__)
+// Cortex-M7 DWT cycle counter, addressed directly so the engine headers
+// don't need CMSIS.
+namespace dwt {
+static volatile uint32_t *const DEMCR = (volatile uint32_t *)0xE000EDFCu;
+static volatile uint32_t *const CTRL = (volatile uint32_t *)0xE0001000u;
+static volatile uint32_t *const CYCCNT = (volatile uint32_t *)0xE0001004u;
+static volatile uint32_t *const LAR = (volatile uint32_t *)0xE0001FB0u;
+} // namespace dwt
+
+inline uint32_t ReadCycleCounter() { return *dwt::CYCCNT; }
+
+inline void EnableCycleCounter() {
+  *dwt::DEMCR |= (1u << 24); // TRCENA
+  *dwt::LAR = 0xC5ACCE55u;   // unlock DWT on the M7
+  *dwt::CYCCNT = 0;
+  *dwt::CTRL |= 1u; // CYCCNTENA
+}
+#else
+// Host builds count nanoseconds instead of cycles.
+inline uint32_t ReadCycleCounter() {
+  return (uint32_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+inline void EnableCycleCounter() {}
+#endif
+
+class DspProfiler {
+public:
+  struct Stat {
+    uint32_t min, max;
+    uint64_t sum;
+    uint32_t Avg(uint32_t count) const {
+      return count ? (uint32_t)(sum / count) : 0;
+    }
+  };
+
+  /** Copy of the counters, taken by the main loop. */
+  struct Snapshot {
+    uint32_t blocks;
+    uint32_t overruns;
+    uint32_t deadline; // cycles available per callback
+    Stat total;
+    Stat stage[PROF_STAGE_LAST];
+  };
+
+  void Init(uint32_t cpu_hz, float sample_rate, size_t block_size) {
+    EnableCycleCounter();
+    deadline_ = (uint32_t)((float)cpu_hz * (float)block_size / sample_rate);
+    Reset();
+  }
+
+  /** Clears the statistics, safe to call from the main loop. */
+  void Reset() { reset_request_ = true; }
+
+  inline void BlockBegin() {
+    if (reset_request_) {
+      Clear();
+      reset_request_ = false;
+    }
+    for (int s = 0; s < PROF_STAGE_LAST; s++)
+      block_stage_[s] = 0;
+    block_start_ = ReadCycleCounter();
+    last_ = block_start_;
+  }
+
+  inline void Mark(ProfStage stage) {
+    uint32_t now = ReadCycleCounter();
+    block_stage_[stage] += now - last_;
+    last_ = now;
+  }
+
+  inline void BlockEnd() {
+    uint32_t total = ReadCycleCounter() - block_start_;
+    Accumulate(snap_.total, total);
+    for (int s = 0; s < PROF_STAGE_LAST; s++)
+      Accumulate(snap_.stage[s], block_stage_[s]);
+    if (total > deadline_)
+      snap_.overruns++;
+    snap_.blocks++;
+  }
+
+  /** The copy may mix two callbacks' worth of counters; fine for a readout. */
+  Snapshot GetSnapshot() const {
+    Snapshot s = snap_;
+    s.deadline = deadline_;
+    return s;
+  }
+
+private:
+  Snapshot snap_;
+  uint32_t deadline_;
+  uint32_t block_start_, last_;
+  uint32_t block_stage_[PROF_STAGE_LAST];
+  volatile bool reset_request_;
+
+  static void ClearStat(Stat &st) {
+    st.min = UINT32_MAX;
+    st.max = 0;
+    st.sum = 0;
+  }
+
+  static inline void Accumulate(Stat &st, uint32_t v) {
+    if (v < st.min)
+      st.min = v;
+    if (v > st.max)
+      st.max = v;
+    st.sum += v;
+  }
+
+  void Clear() {
+    snap_.blocks = 0;
+    snap_.overruns = 0;
+    ClearStat(snap_.total);
+    for (int s = 0; s < PROF_STAGE_LAST; s++)
+      ClearStat(snap_.stage[s]);
+  }
+};
+
+#ifdef OAM_PROFILE
+extern DspProfiler dsp_profiler; // defined in main.cpp
+#define OAM_PROF_BLOCK_BEGIN() oam::dsp_profiler.BlockBegin()
+#define OAM_PROF_MARK(stage) oam::dsp_profiler.Mark(stage)
+#define OAM_PROF_BLOCK_END() oam::dsp_profiler.BlockEnd()
+#else
+#define OAM_PROF_BLOCK_BEGIN()
+#define OAM_PROF_MARK(stage)
+#define OAM_PROF_BLOCK_END()
+#endif
+
+} // namespace oam
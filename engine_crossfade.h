@@ -0,0 +1,71 @@
+#pragma once
+#include <cstddef>
+
+/**
+ * Gain ramps for handing the output over from one engine to another.
+ *
+ * Start() arms a ramp of `samples` samples, then each call consumes `size`
+ * of it; once it is done the gain stays at the end value. The ramps are
+ * linear: both sides carry the same dry signal, which a linear fade keeps
+ * at constant level, and at 10-20 ms the dip in the wet part is not heard.
+ *
+ * S is the step between frames in the buffers, 2 for interleaved L/R.
+ */
+
+namespace oam {
+
+class EngineCrossfade {
+public:
+  void Start(size_t samples) {
+    len_ = samples > 0 ? samples : 1;
+    pos_ = 0;
+    inv_len_ = 1.0f / (float)len_;
+  }
+
+  bool Done() const { return pos_ >= len_; }
+
+  /** a = a * (1 - g) + b * g, g rising from 0 to 1 */
+  template <size_t S = 1>
+  void Mix(float *a_l, float *a_r, const float *b_l, const float *b_r,
+           size_t size) {
+    for (size_t i = 0; i < size; i++) {
+      float g = Next();
+      a_l[i * S] += (b_l[i * S] - a_l[i * S]) * g;
+      a_r[i * S] += (b_r[i * S] - a_r[i * S]) * g;
+    }
+  }
+
+  /** Scales by g rising from 0 to 1 */
+  template <size_t S = 1>
+  void FadeIn(float *l, float *r, size_t size) {
+    for (size_t i = 0; i < size; i++) {
+      float g = Next();
+      l[i * S] *= g;
+      r[i * S] *= g;
+    }
+  }
+
+  /** Scales by 1 - g, ending in silence */
+  template <size_t S = 1>
+  void FadeOut(float *l, float *r, size_t size) {
+    for (size_t i = 0; i < size; i++) {
+      float g = 1.0f - Next();
+      l[i * S] *= g;
+      r[i * S] *= g;
+    }
+  }
+
+private:
+  float Next() {
+    if (pos_ >= len_)
+      return 1.0f;
+    pos_++;
+    return (float)pos_ * inv_len_;
+  }
+
+  size_t len_ = 1;
+  size_t pos_ = 1;
+  float inv_len_ = 1.0f;
+};
+
+} // namespace oam
@@ -0,0 +1,171 @@
+#pragma once
+#include <cstdint>
+#include <cstring>
+
+/**
+ * Fast math for the audio path.
+ *
+ * Polynomial replacements for the libm calls the engines make per sample or
+ * per block, plus a small PRNG to use instead of rand(). Everything is
+ * inline float code with no library calls, so it is cheap, reentrant and
+ * gives the same result on every run. Worst-case errors over the stated
+ * ranges, checked against libm by host/microbench:
+ *
+ *   FastExp2(x)    relative 3e-7    x in [-126, 126], clamped outside
+ *   FastExp(x)     relative 1e-6    |x| <= 10 (grows ~6e-8 per unit of x)
+ *   FastLog2(x)    absolute 1e-6    x > 0 and normal (relative above 1)
+ *   FastPow(x, y)  relative 4e-6    x in [1e-3, 4], |y| <= 4; 0 for x <= 0
+ *   FastSin(x)     absolute 5e-7    |x| <= 1000
+ *   FastAtan(x)    absolute 3e-7    any x
+ *
+ * The polynomials are Chebyshev-node fits, close to minimax.
+ */
+
+namespace oam {
+
+namespace fast_math_detail {
+inline float AsFloat(uint32_t i) {
+  float f;
+  memcpy(&f, &i, sizeof(f));
+  return f;
+}
+inline uint32_t AsBits(float f) {
+  uint32_t i;
+  memcpy(&i, &f, sizeof(i));
+  return i;
+}
+// Truncation towards -inf without floorf
+inline int FloorToInt(float x) {
+  int i = (int)x;
+  return x < (float)i ? i - 1 : i;
+}
+} // namespace fast_math_detail
+
+inline float FastExp2(float x) {
+  x = x < -126.0f ? -126.0f : (x > 126.0f ? 126.0f : x);
+  int i = fast_math_detail::FloorToInt(x);
+  float f = x - (float)i;
+  // 2^f on [0, 1)
+  float p = 0.0018937541f;
+  p = p * f + 0.0089495904f;
+  p = p * f + 0.055860337f;
+  p = p * f + 0.24014182f;
+  p = p * f + 0.69315449f;
+  p = p * f + 0.99999990f;
+  return p * fast_math_detail::AsFloat((uint32_t)(i + 127) << 23);
+}
+
+inline float FastExp(float x) { return FastExp2(x * 1.44269504f); }
+
+inline float FastLog2(float x) {
+  uint32_t bits = fast_math_detail::AsBits(x);
+  int e = (int)((bits >> 23) & 0xFF) - 127;
+  float m = fast_math_detail::AsFloat((bits & 0x007FFFFFu) | 0x3F800000u);
+  // Centre the mantissa on 1 so the fit runs over [-0.29, 0.41]
+  if (m > 1.41421356f) {
+    m *= 0.5f;
+    e++;
+  }
+  float t = m - 1.0f;
+  float p = 0.16818659f;
+  p = p * t - 0.26796387f;
+  p = p * t + 0.29611956f;
+  p = p * t - 0.35952446f;
+  p = p * t + 0.48061313f;
+  p = p * t - 0.72136018f;
+  p = p * t + 1.4426965f;
+  return (float)e + p * t;
+}
+
+inline float FastPow(float x, float y) {
+  if (x <= 0.0f)
+    return 0.0f;
+  return FastExp2(y * FastLog2(x));
+}
+
+// sin(2 pi t) for t in [-0.5, 0.5]
+inline float FastSinTurns(float t) {
+  if (t > 0.25f)
+    t = 0.5f - t;
+  else if (t < -0.25f)
+    t = -0.5f - t;
+  float u = t * t;
+  float p = 39.759827f;
+  p = p * u - 76.581173f;
+  p = p * u + 81.602476f;
+  p = p * u - 41.341681f;
+  p = p * u + 6.2831853f;
+  return p * t;
+}
+
+inline float FastSin(float x) {
+  // Reduce to [-pi, pi] with 2 pi split in two (Cody-Waite), k * 6.28125 is
+  // exact for the documented range
+  float k = (float)fast_math_detail::FloorToInt(x * 0.159154943f + 0.5f);
+  float r = (x - k * 6.28125f) - k * 1.93530718e-3f;
+  return FastSinTurns(r * 0.159154943f);
+}
+
+inline float FastAtan(float x) {
+  float a = x < 0.0f ? -x : x;
+  bool invert = a > 1.0f;
+  float z = invert ? 1.0f / a : a;
+  float u = z * z;
+  float p = 0.0076483539f;
+  p = p * u - 0.036360431f;
+  p = p * u + 0.083126453f;
+  p = p * u - 0.13447864f;
+  p = p * u + 0.19872040f;
+  p = p * u - 0.33325678f;
+  p = p * u + 0.99999923f;
+  p *= z;
+  if (invert)
+    p = 1.57079633f - p;
+  return x < 0.0f ? -p : p;
+}
+
+/** xorshift32, one per object that needs noise. Never returns 0. */
+class XorShift32 {
+public:
+  void Seed(uint32_t seed) { state_ = seed ? seed : 0x9E3779B9u; }
+  uint32_t Next() {
+    uint32_t x = state_;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    state_ = x;
+    return x;
+  }
+  /** [0, 1) */
+  float Uniform() { return (float)(Next() >> 8) * (1.0f / 16777216.0f); }
+  /** [-1, 1) */
+  float Bipolar() { return Uniform() * 2.0f - 1.0f; }
+
+private:
+  uint32_t state_ = 0x9E3779B9u;
+};
+
+/** Sine LFO on FastSinTurns, a drop-in for the Oscillator WAVE_SIN LFOs. */
+class SineLfo {
+public:
+  void Init(float sample_rate) {
+    sample_rate_ = sample_rate;
+    phase_ = 0.0f;
+    inc_ = 0.0f;
+    amp_ = 1.0f;
+  }
+  void SetFreq(float freq) { inc_ = freq / sample_rate_; }
+  void SetAmp(float amp) { amp_ = amp; }
+  float Process() {
+    float out = FastSinTurns(phase_) * amp_;
+    phase_ += inc_;
+    if (phase_ >= 0.5f)
+      phase_ -= 1.0f;
+    return out;
+  }
+
+private:
+  float sample_rate_, phase_, inc_, amp_;
+};
+
+} // namespace oam
@@ -1,5 +1,8 @@
 #pragma once
 #include "daisysp.h"
+#include "dry_wet.h"
+#include "fast_math.h"
+#include "ring_buffer.h"
 #include <cmath>
 
 using namespace daisysp;
@@ -18,43 +21,39 @@ using namespace daisysp;
 // Helper Class for Input Diffusion
 class SimpleAllpass {
 public:
+  // Room for the longest diffuser at 96 kHz
+  static constexpr int kMaxSamples = 2048;
+  static_assert(kMaxSamples == oam::RingSize(kMaxSamples),
+                "ring buffers are a power of two");
+
   void Init() {
-    for (int i = 0; i < 600; i++)
-      buffer_[i] = 0.0f;
-    write_ptr_ = 0;
+    ring_.Init(buffer_, kMaxSamples);
+    ring_.Clear();
     delay_len_ = 100;
   }
   void SetDelay(int len) {
     delay_len_ = len;
-    if (len > 599)
-      delay_len_ = 599;
+    if (len > kMaxSamples - 1)
+      delay_len_ = kMaxSamples - 1;
   }
   float Process(float in) {
     // Standard Schroeder Allpass:
     // out = -g * in + buf[read]
     // buf[write] = in + g * buf[read]
 
-    int read_ptr = write_ptr_ - delay_len_;
-    if (read_ptr < 0)
-      read_ptr += 600;
-
-    float buf_out = buffer_[read_ptr];
+    float buf_out = ring_.Tap(delay_len_);
     float g = 0.5f; // Fixed gain for diffusion
 
     float out = -in + buf_out;
-    buffer_[write_ptr_] = in + (g * buf_out);
-
-    write_ptr_++;
-    if (write_ptr_ >= 600)
-      write_ptr_ = 0;
+    ring_.Write(in + (g * buf_out));
 
     return out;
   }
 
 private:
-  float buffer_[600];
-  int write_ptr_;
-  int delay_len_;
+  float buffer_[kMaxSamples];
+  oam::RingBuffer<float> ring_;
+  uint32_t delay_len_;
 };
 
 // Buffers defined in main.cpp to use SDRAM
@@ -67,19 +66,20 @@ public:
   void Init(float sample_rate, DelayLine<float, 240000> *delays) {
     sample_rate_ = sample_rate;
     delays_ = delays; // Pointer to SDRAM array
+    dry_wet_.Reset();
 
     // Initialize Diffusers (Input Allpasses)
-    // Values chosen to smear transients without ringing
-    int diff_lens[4] = {225, 341, 441, 556};
+    // Values chosen to smear transients without ringing: 225, 341, 441
+    // and 556 samples at 48 kHz
+    const float diff_ms[4] = {4.6875f, 7.1042f, 9.1875f, 11.5833f};
     for (int i = 0; i < 4; i++) {
       diffusers_[i].Init();
-      diffusers_[i].SetDelay(diff_lens[i]);
+      diffusers_[i].SetDelay((int)(diff_ms[i] * 0.001f * sample_rate + 0.5f));
     }
 
     // Initialize LFOs for Modulation
     for (int i = 0; i < N_LINES; i++) {
       mod_lfos_[i].Init(sample_rate);
-      mod_lfos_[i].SetWaveform(Oscillator::WAVE_SIN);
       mod_lfos_[i].SetAmp(1.0f);
       float rate = 0.1f + (i * 0.05f); // 0.1Hz to 0.5Hz spread
       mod_lfos_[i].SetFreq(rate);
@@ -91,15 +91,19 @@ public:
     }
 
     master_decay_ = 0.5f;
-    mod_depth_ = 10.0f; // Samples
+    mod_depth_ = 10.0f * sample_rate / 48000.0f; // 10 samples at 48 kHz
   }
 
+  // Writes the final dry/wet mix, dry_mix ramps over the block. Frames are
+  // S floats apart, S = 2 runs on interleaved L/R buffers.
+  template <size_t S = 1>
   void ProcessBlock(const float *in_l, const float *in_r, float *out_l,
                     float *out_r, size_t size, const float *line_gains,
-                    float time_scale, float skew) {
+                    float time_scale, float skew, float dry_mix) {
+    dry_wet_.Begin(dry_mix, size);
     for (size_t i = 0; i < size; i++) {
-      float dry_l = in_l[i];
-      float dry_r = in_r[i];
+      float dry_l = in_l[i * S];
+      float dry_r = in_r[i * S];
       float input_mix = (dry_l + dry_r) * 0.5f;
 
       // 1. Input Diffusion (Smear Transients)
@@ -113,10 +117,10 @@ public:
       for (int k = 0; k < N_LINES; k++) {
         // Calculate Target Delay
         float ratio = base_ratios_[k];
-        float skewed_ratio = powf(ratio, 0.5f + skew);
+        float skewed_ratio = oam::FastPow(ratio, 0.5f + skew);
 
         float base_samps = skewed_ratio * time_scale * sample_rate_ * 0.1f;
-        // Clamp limits
+        // Clamp limits, the top one is the DelayLine's length
         if (base_samps > 230000.0f)
           base_samps = 230000.0f;
         if (base_samps < 100.0f)
@@ -178,8 +182,9 @@ public:
       out_r_accum =
           delay_outs[1] - delay_outs[3] + delay_outs[5] - delay_outs[7];
 
-      out_l[i] = out_l_accum * 0.25f;
-      out_r[i] = out_r_accum * 0.25f;
+      float dry = dry_wet_.Next();
+      out_l[i * S] = (out_l_accum * 0.25f) * (1.0f - dry) + dry_l * dry;
+      out_r[i * S] = (out_r_accum * 0.25f) * (1.0f - dry) + dry_r * dry;
     }
   }
 
@@ -190,11 +195,12 @@ private:
   DelayLine<float, 240000> *delays_; // Reference to SDRAM
   SimpleAllpass diffusers_[4];
 
-  Oscillator mod_lfos_[N_LINES];
+  oam::SineLfo mod_lfos_[N_LINES];
   OnePole damp_filters_[N_LINES];
 
   float master_decay_;
   float mod_depth_;
+  oam::DryWetRamp dry_wet_;
 
   const float base_ratios_[8] = {1.000f, 1.137f, 1.289f, 1.458f,
                                  1.632f, 1.815f, 2.053f, 2.311f};
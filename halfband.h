@@ -0,0 +1,89 @@
+#pragma once
+#include <cstddef>
+
+/**
+ * Polyphase half-band resamplers, 2:1 and 1:2.
+ *
+ * One 23-tap half-band FIR: flat to 0.1875 fs (9 kHz at 48 kHz, ripple
+ * -54 dB), 54 dB down from 0.3125 fs. Every other tap is zero and the
+ * centre tap is 0.5, so each polyphase branch is either a 12-tap symmetric
+ * FIR (6 multiplies, folded) or a plain delay. Both sides delay by 11
+ * samples at the full rate.
+ *
+ * The histories are written twice, kTaps apart, so the FIR reads them
+ * without wrapping.
+ */
+
+namespace oam {
+
+struct Halfband {
+  static constexpr int kFolded = 6;
+  static constexpr int kTaps = 2 * kFolded; // FIR branch length
+  static constexpr int kDelay = kFolded - 1; // delay branch, low-rate samples
+
+  /** hist[0] newest .. hist[kTaps - 1] oldest */
+  static float Fir(const float *hist) {
+    // Non-zero side taps, outermost first
+    const float coeffs[kFolded] = {-0.003796835f, 0.009917317f,
+                                   -0.022048909f, 0.044625246f,
+                                   -0.093640581f, 0.313969265f};
+    float acc = 0.0f;
+    for (int i = 0; i < kFolded; i++)
+      acc += coeffs[i] * (hist[i] + hist[kTaps - 1 - i]);
+    return acc;
+  }
+};
+
+/** 2:1, one output per pair of input samples */
+class HalfbandDecimator {
+public:
+  void Reset() {
+    for (float &s : fir_)
+      s = 0.0f;
+    for (float &s : delay_)
+      s = 0.0f;
+    pos_ = 0;
+    delay_pos_ = 0;
+  }
+
+  /** a and b are consecutive input samples, a first */
+  float Process(float a, float b) {
+    pos_ = pos_ == 0 ? Halfband::kTaps - 1 : pos_ - 1;
+    fir_[pos_] = fir_[pos_ + Halfband::kTaps] = b;
+    float delayed = delay_[delay_pos_];
+    delay_[delay_pos_] = a;
+    if (++delay_pos_ >= Halfband::kDelay)
+      delay_pos_ = 0;
+    return Halfband::Fir(&fir_[pos_]) + 0.5f * delayed;
+  }
+
+private:
+  float fir_[2 * Halfband::kTaps];
+  float delay_[Halfband::kDelay];
+  int pos_ = 0;
+  int delay_pos_ = 0;
+};
+
+/** 1:2, two output samples per input */
+class HalfbandInterpolator {
+public:
+  void Reset() {
+    for (float &s : fir_)
+      s = 0.0f;
+    pos_ = 0;
+  }
+
+  /** Writes the two output samples for `in`, a first */
+  void Process(float in, float &a, float &b) {
+    pos_ = pos_ == 0 ? Halfband::kTaps - 1 : pos_ - 1;
+    fir_[pos_] = fir_[pos_ + Halfband::kTaps] = in;
+    a = 2.0f * Halfband::Fir(&fir_[pos_]);
+    b = fir_[pos_ + Halfband::kDelay];
+  }
+
+private:
+  float fir_[2 * Halfband::kTaps];
+  int pos_ = 0;
+};
+
+} // namespace oam
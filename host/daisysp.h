@@ -0,0 +1,431 @@
+#pragma once
+/**
+ * Host stand-in for the subset of DaisySP used by the Omnibus engines.
+ *
+ * Only used by the tools in host/. The classes follow the DaisySP
+ * implementations closely (same per-sample math and the same libm calls in
+ * the same places) so that host timings move in the same direction as the
+ * firmware when an engine changes. They are not bit-exact with the library.
+ */
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+
+namespace daisysp {
+
+#ifndef PI_F
+#define PI_F 3.1415927410125732421875f
+#endif
+#ifndef TWOPI_F
+#define TWOPI_F (2.0f * PI_F)
+#endif
+
+inline float fclamp(float in, float min, float max) {
+  return fminf(fmaxf(in, min), max);
+}
+
+inline float mtof(float m) { return powf(2.0f, (m - 69.0f) / 12.0f) * 440.0f; }
+
+template <typename T, size_t max_size> class DelayLine {
+public:
+  void Init() { Reset(); }
+  void Reset() {
+    for (size_t i = 0; i < max_size; i++)
+      line_[i] = T(0);
+    write_ptr_ = 0;
+    delay_ = 1;
+  }
+  void SetDelay(size_t delay) {
+    frac_ = 0.0f;
+    delay_ = delay < max_size ? delay : max_size - 1;
+  }
+  void SetDelay(float delay) {
+    int32_t int_delay = static_cast<int32_t>(delay);
+    frac_ = delay - static_cast<float>(int_delay);
+    delay_ = static_cast<size_t>(int_delay) < max_size ? int_delay
+                                                       : max_size - 1;
+  }
+  void Write(const T sample) {
+    line_[write_ptr_] = sample;
+    write_ptr_ = (write_ptr_ - 1 + max_size) % max_size;
+  }
+  const T Read() const {
+    T a = line_[(write_ptr_ + delay_) % max_size];
+    T b = line_[(write_ptr_ + delay_ + 1) % max_size];
+    return a + (b - a) * frac_;
+  }
+  const T Read(float delay) const {
+    int32_t delay_integral = static_cast<int32_t>(delay);
+    float delay_fractional = delay - static_cast<float>(delay_integral);
+    const T a = line_[(write_ptr_ + delay_integral) % max_size];
+    const T b = line_[(write_ptr_ + delay_integral + 1) % max_size];
+    return a + (b - a) * delay_fractional;
+  }
+
+private:
+  float frac_;
+  size_t write_ptr_;
+  size_t delay_;
+  T line_[max_size];
+};
+
+class Oscillator {
+public:
+  enum { WAVE_SIN, WAVE_TRI, WAVE_SAW, WAVE_RAMP, WAVE_SQUARE, WAVE_LAST };
+
+  void Init(float sample_rate) {
+    sr_ = sample_rate;
+    sr_recip_ = 1.0f / sample_rate;
+    freq_ = 100.0f;
+    amp_ = 0.5f;
+    phase_ = 0.0f;
+    phase_inc_ = freq_ * sr_recip_;
+    waveform_ = WAVE_SIN;
+  }
+  void SetFreq(const float f) {
+    freq_ = f;
+    phase_inc_ = f * sr_recip_;
+  }
+  void SetAmp(const float a) { amp_ = a; }
+  void SetWaveform(const uint8_t wf) { waveform_ = wf < WAVE_LAST ? wf : 0; }
+
+  float Process() {
+    float out;
+    switch (waveform_) {
+    case WAVE_SIN:
+      out = sinf(phase_ * TWOPI_F);
+      break;
+    case WAVE_TRI: {
+      float t = -1.0f + (2.0f * phase_);
+      out = 2.0f * (fabsf(t) - 0.5f);
+    } break;
+    case WAVE_SAW:
+      out = -1.0f * (((phase_ * 2.0f)) - 1.0f);
+      break;
+    case WAVE_RAMP:
+      out = ((phase_ * 2.0f)) - 1.0f;
+      break;
+    default:
+      out = phase_ < 0.5f ? 1.0f : -1.0f;
+      break;
+    }
+    phase_ += phase_inc_;
+    if (phase_ > 1.0f)
+      phase_ -= 1.0f;
+    return out * amp_;
+  }
+
+private:
+  uint8_t waveform_;
+  float amp_, freq_;
+  float sr_, sr_recip_, phase_, phase_inc_;
+};
+
+class Phasor {
+public:
+  void Init(float sample_rate, float freq, float initial_phase) {
+    sample_rate_ = sample_rate;
+    phs_ = initial_phase;
+    SetFreq(freq);
+  }
+  void SetFreq(float freq) {
+    freq_ = freq;
+    inc_ = (TWOPI_F * freq_) / sample_rate_;
+  }
+  float Process() {
+    float out = phs_ / TWOPI_F;
+    phs_ += inc_;
+    if (phs_ > TWOPI_F)
+      phs_ -= TWOPI_F;
+    if (phs_ < 0.0f)
+      phs_ = 0.0f;
+    return out;
+  }
+
+private:
+  float freq_, sample_rate_, inc_, phs_;
+};
+
+class Svf {
+public:
+  void Init(float sample_rate) {
+    sr_ = sample_rate;
+    fc_ = 200.0f;
+    res_ = 0.5f;
+    drive_ = 0.5f;
+    pre_drive_ = 0.5f;
+    freq_ = 0.25f;
+    damp_ = 0.0f;
+    notch_ = low_ = high_ = band_ = peak_ = 0.0f;
+    input_ = 0.0f;
+    out_low_ = out_high_ = out_band_ = out_peak_ = out_notch_ = 0.0f;
+    fc_max_ = sr_ / 3.0f;
+  }
+
+  void Process(float in) {
+    input_ = in;
+    // first pass
+    notch_ = input_ - damp_ * band_;
+    low_ = low_ + freq_ * band_;
+    high_ = notch_ - low_;
+    band_ = freq_ * high_ + band_ - drive_ * band_ * band_ * band_;
+    out_low_ = 0.5f * low_;
+    out_high_ = 0.5f * high_;
+    out_band_ = 0.5f * band_;
+    out_peak_ = 0.5f * (low_ - high_);
+    out_notch_ = 0.5f * notch_;
+    // second pass
+    notch_ = input_ - damp_ * band_;
+    low_ = low_ + freq_ * band_;
+    high_ = notch_ - low_;
+    band_ = freq_ * high_ + band_ - drive_ * band_ * band_ * band_;
+    out_low_ += 0.5f * low_;
+    out_high_ += 0.5f * high_;
+    out_band_ += 0.5f * band_;
+    out_peak_ += 0.5f * (low_ - high_);
+    out_notch_ += 0.5f * notch_;
+  }
+
+  void SetFreq(float f) {
+    fc_ = fclamp(f, 1.0e-6f, fc_max_);
+    freq_ = 2.0f * sinf(PI_F * fminf(0.25f, fc_ / (sr_ * 2.0f)));
+    damp_ = fminf(2.0f * (1.0f - powf(res_, 0.25f)),
+                  fminf(2.0f, 2.0f / freq_ - freq_ * 0.5f));
+  }
+  void SetRes(float r) {
+    res_ = fclamp(r, 0.0f, 1.0f);
+    damp_ = fminf(2.0f * (1.0f - powf(res_, 0.25f)),
+                  fminf(2.0f, 2.0f / freq_ - freq_ * 0.5f));
+    drive_ = pre_drive_ * res_;
+  }
+  void SetDrive(float d) {
+    pre_drive_ = fclamp(d, 0.0f, 1.0f);
+    drive_ = pre_drive_ * res_;
+  }
+
+  float Low() { return out_low_; }
+  float High() { return out_high_; }
+  float Band() { return out_band_; }
+  float Notch() { return out_notch_; }
+  float Peak() { return out_peak_; }
+
+private:
+  float sr_, fc_, res_, drive_, freq_, damp_;
+  float notch_, low_, high_, band_, peak_;
+  float input_;
+  float out_low_, out_high_, out_band_, out_peak_, out_notch_;
+  float pre_drive_, fc_max_;
+};
+
+class OnePole {
+public:
+  enum FilterMode { FILTER_MODE_LOW_PASS, FILTER_MODE_HIGH_PASS };
+
+  void Init() {
+    state_ = 0.0f;
+    filter_mode_ = FILTER_MODE_LOW_PASS;
+    SetFrequency(0.25f);
+  }
+  void SetFrequency(float freq) {
+    freq = fminf(freq, 0.497f);
+    const float g = tanf(PI_F * freq);
+    gi_ = g / (1.0f + g);
+  }
+  void SetFilterMode(FilterMode mode) { filter_mode_ = mode; }
+  float Process(float in) {
+    float v = (in - state_) * gi_;
+    float out = v + state_;
+    state_ = out + v;
+    return filter_mode_ == FILTER_MODE_LOW_PASS ? out : in - out;
+  }
+
+private:
+  float gi_, state_;
+  FilterMode filter_mode_;
+};
+
+#define SHIFT_BUFFER_SIZE 16384
+
+class PitchShifter {
+public:
+  void Init(float sr) {
+    force_recalc_ = false;
+    sr_ = sr;
+    mod_freq_ = 5.0f;
+    transpose_ = 0.0f;
+    for (int i = 0; i < 2; i++) {
+      gain_[i] = 0.0f;
+      d_[i].Init();
+      phs_[i].Init(sr, 50.0f, i == 0 ? 0.0f : PI_F);
+      slewed_mod_[i] = 0.0f;
+      mod_coeff_[i] = 0.0f;
+    }
+    mod_a_amt_ = mod_b_amt_ = 0.0f;
+    prev_phs_a_ = prev_phs_b_ = 0.0f;
+    shift_up_ = true;
+    del_size_ = SHIFT_BUFFER_SIZE;
+    SetDelSize(del_size_);
+    fun_ = 0.0f;
+  }
+
+  float Process(float &in) {
+    float val, fade1, fade2;
+    fade1 = phs_[0].Process();
+    fade2 = phs_[1].Process();
+    if (prev_phs_a_ > fade1) {
+      mod_a_amt_ = fun_ * ((float)(rand() % 255) / 255.0f) * (del_size_ * 0.5f);
+      mod_coeff_[0] = 0.0002f + (((float)(rand() % 255) / 255.0f) * 0.001f);
+    }
+    if (prev_phs_b_ > fade2) {
+      mod_b_amt_ = fun_ * ((float)(rand() % 255) / 255.0f) * (del_size_ * 0.5f);
+      mod_coeff_[1] = 0.0002f + (((float)(rand() % 255) / 255.0f) * 0.001f);
+    }
+    slewed_mod_[0] += mod_coeff_[0] * (mod_a_amt_ - slewed_mod_[0]);
+    slewed_mod_[1] += mod_coeff_[1] * (mod_b_amt_ - slewed_mod_[1]);
+    prev_phs_a_ = fade1;
+    prev_phs_b_ = fade2;
+    if (shift_up_) {
+      fade1 = 1.0f - fade1;
+      fade2 = 1.0f - fade2;
+    }
+    mod_[0] = fade1 * (del_size_ - 1);
+    mod_[1] = fade2 * (del_size_ - 1);
+    gain_[0] = sinf(fade1 * PI_F);
+    gain_[1] = sinf(fade2 * PI_F);
+
+    d_[0].Write(in);
+    d_[1].Write(in);
+    d_[0].SetDelay(mod_[0] + slewed_mod_[0]);
+    d_[1].SetDelay(mod_[1] + slewed_mod_[1]);
+    val = 0.0f;
+    val += (d_[0].Read() * gain_[0]);
+    val += (d_[1].Read() * gain_[1]);
+    return val;
+  }
+
+  void SetTransposition(const float &transpose) {
+    float ratio;
+    uint8_t idx;
+    if (transpose_ != transpose || force_recalc_) {
+      transpose_ = transpose;
+      idx = (uint8_t)fabsf(transpose);
+      ratio = semitone_ratios_[idx % 12];
+      ratio *= (uint8_t)(fabsf(transpose) / 12) + 1;
+      if (transpose > 0.0f) {
+        shift_up_ = true;
+      } else {
+        ratio = 1.0f / ratio;
+        shift_up_ = false;
+      }
+      mod_freq_ = ((ratio - 1.0f) * sr_) / del_size_;
+      if (mod_freq_ < 0.0f)
+        mod_freq_ = 0.0f;
+      phs_[0].SetFreq(mod_freq_);
+      phs_[1].SetFreq(mod_freq_);
+      force_recalc_ = false;
+    }
+  }
+
+  void SetDelSize(uint32_t size) {
+    del_size_ = size < SHIFT_BUFFER_SIZE ? size : SHIFT_BUFFER_SIZE;
+    force_recalc_ = true;
+    SetTransposition(transpose_);
+  }
+
+  void SetFun(float f) { fun_ = f; }
+
+private:
+  DelayLine<float, SHIFT_BUFFER_SIZE> d_[2];
+  float sr_, mod_freq_;
+  uint32_t del_size_;
+  bool shift_up_, force_recalc_;
+  Phasor phs_[2];
+  float gain_[2], mod_[2], transpose_;
+  float fun_, mod_a_amt_, mod_b_amt_, prev_phs_a_, prev_phs_b_;
+  float slewed_mod_[2], mod_coeff_[2];
+  const float semitone_ratios_[12] = {
+      1.000000f, 1.059463f, 1.122462f, 1.189207f, 1.259921f, 1.334840f,
+      1.414214f, 1.498307f, 1.587401f, 1.681793f, 1.781797f, 1.887749f};
+};
+
+class Compressor {
+public:
+  void Init(float sample_rate) {
+    sample_rate_ = fminf(192000.0f, fmaxf(1.0f, sample_rate));
+    sample_rate_inv_ = 1.0f / sample_rate_;
+    sample_rate_inv2_ = 2.0f / sample_rate_;
+    ratio_ = 2.0f;
+    thresh_ = -12.0f;
+    atk_ = 0.1f;
+    rel_ = 0.1f;
+    makeup_gain_ = 0.0f;
+    slope_rec_ = 0.1f;
+    gain_rec_ = 0.1f;
+    gain_ = 1.0f;
+    auto_makeup_ = true;
+    RecalculateSlopes();
+    RecalculateRatio();
+    RecalculateMakeup();
+  }
+
+  float Process(float in) {
+    float inAbs = fabsf(in);
+    float cur_slo = ((slope_rec_ > inAbs) ? rel_slo_ : atk_slo_);
+    slope_rec_ = ((slope_rec_ * cur_slo) + ((1.0f - cur_slo) * inAbs));
+    gain_rec_ =
+        ((atk_slo2_ * gain_rec_) +
+         (ratio_mul_ *
+          fmaxf(((20.0f * log10f(slope_rec_ + 1e-20f)) - thresh_), 0.0f)));
+    gain_ = powf(10.0f, 0.05f * (gain_rec_ + makeup_gain_));
+    return gain_ * in;
+  }
+  float Process(float in, float key) {
+    Process(key);
+    return Apply(in);
+  }
+  float Apply(float in) { return gain_ * in; }
+
+  void SetRatio(float ratio) {
+    ratio_ = fclamp(ratio, 1.0f, 40.0f);
+    RecalculateRatio();
+  }
+  void SetThreshold(float threshold) {
+    thresh_ = fclamp(threshold, -80.0f, 0.0f);
+    RecalculateMakeup();
+  }
+  void SetAttack(float attack) {
+    atk_ = fclamp(attack, 0.001f, 10.0f);
+    RecalculateSlopes();
+  }
+  void SetRelease(float release) {
+    rel_ = fclamp(release, 0.001f, 10.0f);
+    RecalculateSlopes();
+  }
+
+private:
+  float ratio_, thresh_, atk_, rel_;
+  float makeup_gain_;
+  float gain_;
+  float gain_rec_, slope_rec_;
+  float ratio_mul_;
+  float atk_slo_, rel_slo_, atk_slo2_;
+  float sample_rate_, sample_rate_inv_, sample_rate_inv2_;
+  bool auto_makeup_;
+
+  void RecalculateRatio() {
+    ratio_mul_ = ((1.0f - atk_slo2_) * ((1.0f / ratio_) - 1.0f));
+  }
+  void RecalculateMakeup() {
+    makeup_gain_ =
+        auto_makeup_ ? fabsf(thresh_ - thresh_ / ratio_) * 0.5f : 0.0f;
+  }
+  void RecalculateSlopes() {
+    atk_slo2_ = expf(-sample_rate_inv2_ / atk_);
+    atk_slo_ = expf(-sample_rate_inv_ / atk_);
+    rel_slo_ = expf(-sample_rate_inv_ / rel_);
+    RecalculateRatio();
+  }
+};
+
+} // namespace daisysp
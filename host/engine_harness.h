@@ -0,0 +1,325 @@
+#pragma once
+/**
+ * Host copy of the glue in main.cpp: owns one instance of every engine and
+ * drives it the same way AudioCallbackReal and the main control loop do.
+ * Keep this in step with main.cpp when the callback or the control mapping
+ * changes, otherwise the host numbers stop meaning anything.
+ */
+#include "daisysp.h"
+#include "engine_crossfade.h"
+#include "fdn.h"
+#include "legacy_engine.h"
+#include "omni_resonator.h"
+#include "sdram_arena.h"
+#include "uber_fdn.h"
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <string>
+#include <vector>
+
+namespace oam {
+namespace host {
+
+enum HostMode {
+  HOST_STUDIO,
+  HOST_SHIMMER,
+  HOST_MASSIVE,
+  HOST_RESONATOR,
+  HOST_LEGACY,
+  HOST_SUPERFDN, // fdn.h, not reachable from the firmware
+  HOST_MODE_LAST
+};
+
+inline const char *ModeName(int m) {
+  static const char *names[HOST_MODE_LAST] = {
+      "studio", "shimmer", "massive", "resonator", "legacy", "superfdn"};
+  return m >= 0 && m < HOST_MODE_LAST ? names[m] : "?";
+}
+
+inline int ModeFromName(const std::string &name) {
+  for (int m = 0; m < HOST_MODE_LAST; m++)
+    if (name == ModeName(m))
+      return m;
+  return -1;
+}
+
+/** Everything a control read hands to the engines (ControlFrame). */
+struct Controls {
+  float k_time = 0.5f;
+  float k_mod = 0.5f;
+  float k_decay = 0.6f;
+  float dry_mix = 0.3f;
+  float sliders[8] = {0.7f, 0.7f, 0.7f, 0.7f, 0.7f, 0.7f, 0.7f, 0.7f};
+  int mode = -1; // engine switch, as the gate 1 gesture; -1 for none
+  bool strike = false; // gate 2 rising edge, one control read only
+
+  /** Sets a control by the name used in render scripts. */
+  bool Set(const std::string &name, float v) {
+    // The knobs are clamped to 0..1 as ReadControls() does, the engines
+    // rely on it
+    if (name == "time")
+      k_time = Clamp01(v);
+    else if (name == "mod" || name == "skew")
+      k_mod = Clamp01(v);
+    else if (name == "decay" || name == "feedback")
+      k_decay = Clamp01(v);
+    else if (name == "dry")
+      dry_mix = v;
+    else if (name == "mode")
+      mode = (int)v;
+    else if (name == "strike")
+      strike = v > 0.0f;
+    else if (name == "sliders")
+      for (int i = 0; i < 8; i++)
+        sliders[i] = v;
+    else if (name.size() == 7 && name.compare(0, 6, "slider") == 0 &&
+             name[6] >= '1' && name[6] <= '8')
+      sliders[name[6] - '1'] = v;
+    else
+      return false;
+    return true;
+  }
+
+  static float Clamp01(float v) { return std::min(1.0f, std::max(0.0f, v)); }
+};
+
+// Samples per control read at 48 kHz, kControlPeriod's default in main.cpp
+static constexpr size_t kControlPeriod = 32;
+
+/** Blocks per control read, control_blocks in main.cpp */
+inline size_t ControlBlocks(size_t block, float sample_rate = 48000.0f) {
+  size_t period = (size_t)((float)kControlPeriod * sample_rate / 48000.0f);
+  return std::max((size_t)1, period / block);
+}
+
+/** main.cpp's BlockSizeFor(), the firmware block size per mode */
+inline size_t BlockSizeFor(int mode) {
+  switch (mode) {
+  case HOST_RESONATOR:
+    return 8;
+  case HOST_MASSIVE:
+    return 64;
+  default:
+    return 32;
+  }
+}
+
+// 64MB, as big_sdram_buffer in main.cpp
+static constexpr size_t kSdramSamples = 64 * 1024 * 1024 / sizeof(float);
+
+class EngineHarness {
+public:
+  EngineHarness()
+      : sdram_(kSdramSamples),
+        legacy_windows_(oam::legacy::kPrefetchWindowSamples),
+        super_lines_(new SuperLine[8]) {}
+  ~EngineHarness() { delete[] super_lines_; }
+
+  /** Mirrors the mode-dependent part of main() after the boot selection. */
+  void Init(int mode, float sample_rate) {
+    mode_ = mode;
+    sample_rate_ = sample_rate;
+    switch_state_ = SWITCH_IDLE;
+    controls_fresh_ = false;
+    // SDRAM is not cleared at boot and the engines must not depend on it:
+    // fill it with NaN so any read of unwritten memory shows in the output.
+    std::fill(sdram_.begin(), sdram_.end(),
+              std::numeric_limits<float>::quiet_NaN());
+    // AllocateSdram() in main.cpp
+    arena_.Init(sdram_.data(), sdram_.size() * sizeof(float));
+    fdn_memory_ =
+        arena_.Allocate<float>(UberFDN<8>::MemorySamples(sample_rate), "fdn");
+    legacy_bytes_ =
+        std::min(oam::legacy::LegacyStereoEngine::MemoryBytes(sample_rate),
+                 arena_.Free() / oam::kArenaAlign * oam::kArenaAlign);
+    legacy_memory_ = arena_.Allocate(legacy_bytes_, "legacy");
+    InitEngine(mode_);
+  }
+
+  /** A control tick of the callback's scheduler: the next block hands `c`
+   *  to the engines and renders with it. Call once per ControlBlocks(). */
+  void UpdateControls(const Controls &c) {
+    controls_ = c;
+    controls_fresh_ = true;
+    if (c.mode >= 0 && c.mode != mode_)
+      RequestSwitch(c.mode, c);
+  }
+
+  /** AudioCallbackReal. S = 2 is the INTERLEAVED=1 build, frames in
+   *  L/R pairs with in_r == in_l + 1. */
+  template <size_t S = 1>
+  void ProcessBlock(const float *in_l, const float *in_r, float *out_l,
+                    float *out_r, size_t size) {
+    const Controls &c = controls_;
+    if (controls_fresh_) {
+      controls_fresh_ = false;
+      UpdateEngine(mode_, c);
+      if (switch_state_ == SWITCH_CROSSFADE)
+        UpdateEngine(next_mode_, c);
+    }
+
+    RenderMode<S>(mode_, c, in_l, in_r, out_l, out_r, size);
+    float *switch_l = switch_buf_;
+    float *switch_r = switch_buf_ + (S == 2 ? 1 : kSwitchChunk);
+    switch (switch_state_) {
+    case SWITCH_IDLE:
+      break;
+    case SWITCH_CROSSFADE: {
+      for (size_t pos = 0; pos < size; pos += kSwitchChunk) {
+        size_t n = std::min(size - pos, kSwitchChunk);
+        const size_t f = pos * S;
+        RenderMode<S>(next_mode_, c, in_l + f, in_r + f, switch_l, switch_r,
+                      n);
+        switch_fade_.Mix<S>(out_l + f, out_r + f, switch_l, switch_r, n);
+      }
+      if (switch_fade_.Done()) {
+        mode_ = next_mode_;
+        switch_state_ = SWITCH_IDLE;
+      }
+      break;
+    }
+    case SWITCH_FADE_OUT:
+      switch_fade_.FadeOut<S>(out_l, out_r, size);
+      if (switch_fade_.Done()) {
+        fdn_.SetMode(FdnModeOf(next_mode_));
+        mode_ = next_mode_;
+        UpdateEngine(next_mode_, c);
+        switch_fade_.Start((size_t)(sample_rate_ * 0.01f));
+        switch_state_ = SWITCH_FADE_IN;
+      }
+      break;
+    case SWITCH_FADE_IN:
+      switch_fade_.FadeIn<S>(out_l, out_r, size);
+      if (switch_fade_.Done())
+        switch_state_ = SWITCH_IDLE;
+      break;
+    }
+  }
+
+private:
+  enum SwitchState {
+    SWITCH_IDLE,
+    SWITCH_CROSSFADE,
+    SWITCH_FADE_OUT,
+    SWITCH_FADE_IN
+  };
+  static constexpr size_t kSwitchChunk = 64;
+
+  static bool IsFdnMode(int m) {
+    return m == HOST_STUDIO || m == HOST_SHIMMER || m == HOST_MASSIVE;
+  }
+
+  static FdnMode FdnModeOf(int m) {
+    return m == HOST_SHIMMER   ? MODE_SHIMMER
+           : m == HOST_MASSIVE ? MODE_MASSIVE
+                               : MODE_STUDIO;
+  }
+
+  void InitEngine(int mode) {
+    switch (mode) {
+    case HOST_STUDIO:
+    case HOST_SHIMMER:
+    case HOST_MASSIVE:
+      fdn_.SetMode(FdnModeOf(mode));
+      fdn_.Init(sample_rate_, fdn_memory_);
+      break;
+    case HOST_RESONATOR:
+      res_.Init(sample_rate_);
+      break;
+    case HOST_LEGACY:
+      legacy_.Init(sample_rate_, legacy_memory_, legacy_bytes_);
+      legacy_prefetch_.Init(sizeof(oam::legacy::Sample), nullptr,
+                            oam::legacy::kPrefetchMaxNodes);
+      legacy_.EnablePrefetch(&legacy_prefetch_, legacy_windows_.data());
+      break;
+    case HOST_SUPERFDN:
+      for (int i = 0; i < 8; i++)
+        super_lines_[i].Init();
+      super_.Init(sample_rate_, super_lines_);
+      break;
+    }
+  }
+
+  void UpdateEngine(int mode, const Controls &c) {
+    if (mode == HOST_LEGACY) {
+      static const float vcas[9] = {1, 1, 1, 1, 1, 1, 1, 1, 1};
+      legacy_.UpdateControls(c.k_time, c.k_mod, c.k_decay, c.dry_mix,
+                             c.sliders, vcas);
+    } else if (mode == HOST_SUPERFDN) {
+      super_.SetMasterDecay(c.k_decay * 0.98f);
+    } else if (mode == HOST_RESONATOR) {
+      if (c.strike)
+        res_.Strike();
+    } else {
+      float safe_decay = c.k_decay;
+      if (mode != HOST_MASSIVE)
+        safe_decay *= 0.98f;
+      fdn_.SetDecay(safe_decay);
+    }
+  }
+
+  // RequestSwitch() in main.cpp; the firmware can't reach superfdn
+  void RequestSwitch(int mode, const Controls &c) {
+    if (switch_state_ != SWITCH_IDLE || mode == mode_ ||
+        mode == HOST_SUPERFDN || mode_ == HOST_SUPERFDN ||
+        mode >= HOST_MODE_LAST)
+      return;
+    if (IsFdnMode(mode) && IsFdnMode(mode_)) {
+      switch_fade_.Start((size_t)(sample_rate_ * 0.01f));
+      switch_state_ = SWITCH_FADE_OUT;
+    } else {
+      InitEngine(mode);
+      UpdateEngine(mode, c);
+      switch_fade_.Start((size_t)(sample_rate_ * 0.02f));
+      switch_state_ = SWITCH_CROSSFADE;
+    }
+    next_mode_ = mode;
+  }
+
+  template <size_t S>
+  void RenderMode(int mode, const Controls &c, const float *in_l,
+                  const float *in_r, float *out_l, float *out_r, size_t size) {
+    const float *gains = c.sliders;
+    if (mode == HOST_LEGACY) {
+      legacy_.ProcessBlock<S>(in_l, in_r, out_l, out_r, size);
+    } else if (mode == HOST_RESONATOR) {
+      res_.ProcessBlock<S>(in_l, in_r, out_l, out_r, size, gains, c.k_time,
+                           c.k_mod, c.k_decay, c.dry_mix);
+    } else if (mode == HOST_SUPERFDN) {
+      super_.ProcessBlock<S>(in_l, in_r, out_l, out_r, size, gains,
+                             0.2f + (c.k_time * 3.0f), c.k_mod, c.dry_mix);
+    } else {
+      fdn_.ProcessBlock<S>(in_l, in_r, out_l, out_r, size, gains,
+                           0.2f + (c.k_time * 3.0f), 0.5f, c.k_mod,
+                           c.dry_mix);
+    }
+  }
+
+  typedef DelayLine<float, 240000> SuperLine;
+
+  int mode_ = HOST_STUDIO;
+  float sample_rate_ = 48000.0f;
+  Controls controls_; // the last control tick's set
+  bool controls_fresh_ = false;
+  SwitchState switch_state_ = SWITCH_IDLE;
+  int next_mode_ = HOST_STUDIO;
+  EngineCrossfade switch_fade_;
+  float switch_buf_[2 * kSwitchChunk]; // incoming engine, block layout
+  std::vector<float> sdram_;
+  SdramArena arena_;
+  float *fdn_memory_ = nullptr;
+  void *legacy_memory_ = nullptr;
+  size_t legacy_bytes_ = 0;
+  std::vector<oam::legacy::Sample> legacy_windows_;
+  MdmaPrefetcher legacy_prefetch_; // copies synchronously on the host
+  SuperLine *super_lines_;
+
+  UberFDN<8> fdn_;
+  OmniResonatorEngine res_;
+  oam::legacy::LegacyStereoEngine legacy_;
+  SuperFDN<8> super_;
+};
+
+} // namespace host
+} // namespace oam
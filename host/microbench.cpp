@@ -0,0 +1,438 @@
+/**
+ * Microbenchmarks for the per-sample DSP primitives.
+ *
+ *   microbench                          print ns/op for every kernel
+ *   microbench --save base.txt          also write the numbers as a baseline
+ *   microbench --baseline base.txt      fail (exit 1) if any kernel is slower
+ *              [--margin 0.15]          than its baseline by more than margin
+ *   microbench --filter Omni            only kernels whose name contains this
+ *
+ * Before timing it checks every fast_math.h function against libm (in
+ * double) over its documented range and fails if an error bound is broken.
+ *
+ * Each kernel runs a realistic parameter sweep; the reported figure is the
+ * fastest of several repetitions, which is the most stable number on a busy
+ * host. Baselines are per machine, so save one before starting on a change.
+ */
+#include "daisysp.h"
+#include "fast_math.h"
+#include "fdn.h"
+#include "legacy_engine.h"
+#include "uber_fdn.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace {
+
+volatile float sink;
+
+const int kOpsPerRun = 1 << 16;
+const int kRuns = 15;
+const float kSampleRate = 48000.0f;
+
+struct Kernel {
+  const char *name;
+  void (*setup)();
+  float (*run)(int ops); // returns a value that depends on every op
+};
+
+// --- State shared by the kernels, allocated once ---
+std::vector<float> delay_mem(oam::RingSize(240000));
+oam::RingBuffer<float> ring;
+OmniAllpass omni_allpass[4];
+SimpleAllpass simple_allpass[4];
+OmniOnePole one_pole;
+std::vector<oam::legacy::Sample> legacy_mem(7200000);
+oam::legacy::ReadHead read_head;
+Svf svf;
+PitchShifter *shifter = new PitchShifter;
+
+const int kDiffLens[4] = {225, 341, 441, 556};
+
+float NoiseSample(uint32_t &seed) {
+  seed = seed * 1664525u + 1013904223u;
+  return ((seed >> 9) / 8388608.0f) * 2.0f - 1.0f;
+}
+
+// RingBuffer::Read with an LFO-modulated read position across the whole
+// line, the way UberFDN uses it (base time plus up to 100 samples of wander).
+void SetupRingRead() {
+  uint32_t seed = 1;
+  for (float &s : delay_mem)
+    s = NoiseSample(seed);
+  ring.Init(delay_mem.data(), delay_mem.size());
+}
+float RunRingRead(int ops) {
+  float acc = 0.0f;
+  float base = 1000.0f;
+  for (int i = 0; i < ops; i++) {
+    float mod = 100.0f * sinf(i * 0.0005f);
+    acc += ring.Read(base + mod);
+    ring.Write(acc * 1e-6f);
+    base += 3.5f;
+    if (base > 230000.0f)
+      base = 1000.0f;
+  }
+  return acc;
+}
+
+void SetupOmniAllpass() {
+  for (int k = 0; k < 4; k++) {
+    omni_allpass[k].Init();
+    omni_allpass[k].SetDelay(kDiffLens[k]);
+  }
+}
+float RunOmniAllpass(int ops) {
+  uint32_t seed = 2;
+  float acc = 0.0f;
+  for (int i = 0; i < ops; i++) {
+    float x = NoiseSample(seed);
+    x = omni_allpass[i & 3].Process(x);
+    acc += x;
+  }
+  return acc;
+}
+
+void SetupSimpleAllpass() {
+  for (int k = 0; k < 4; k++) {
+    simple_allpass[k].Init();
+    simple_allpass[k].SetDelay(kDiffLens[k]);
+  }
+}
+float RunSimpleAllpass(int ops) {
+  uint32_t seed = 3;
+  float acc = 0.0f;
+  for (int i = 0; i < ops; i++) {
+    float x = NoiseSample(seed);
+    x = simple_allpass[i & 3].Process(x);
+    acc += x;
+  }
+  return acc;
+}
+
+void SetupOnePole() { one_pole.Init(kSampleRate); }
+float RunOnePole(int ops) {
+  uint32_t seed = 4;
+  float acc = 0.0f;
+  for (int i = 0; i < ops; i++)
+    acc += one_pole.Process(NoiseSample(seed));
+  return acc;
+}
+
+// SetFreq + Process, as UberFDN does per sample and line in Studio/Shimmer
+float RunOnePoleSetFreq(int ops) {
+  uint32_t seed = 5;
+  float acc = 0.0f;
+  for (int i = 0; i < ops; i++) {
+    float gain = (i & 1023) / 1023.0f;
+    one_pole.SetFreq(2000.0f + gain * 8000.0f);
+    acc += one_pole.Process(NoiseSample(seed));
+  }
+  return acc;
+}
+
+void SetupNone() {}
+float RunSoftClip(int ops) {
+  float acc = 0.0f;
+  float x = -3.0f;
+  for (int i = 0; i < ops; i++) {
+    acc += oam::legacy::LegacyHelpers::softClip(x);
+    x += 0.0001f;
+    if (x > 3.0f)
+      x = -3.0f;
+  }
+  return acc;
+}
+
+// ReadHead::Process with targets retimed every 256 samples, spread over the
+// full 150 s buffer as in Legacy mode with the time knob moving.
+void SetupReadHead() {
+  uint32_t seed = 6;
+  for (oam::legacy::Sample &s : legacy_mem)
+    s = oam::legacy::PackSample(NoiseSample(seed));
+  read_head = oam::legacy::ReadHead();
+  read_head.Init(kSampleRate, legacy_mem.data(), (int)legacy_mem.size(), 1);
+}
+float RunReadHead(int ops) {
+  float acc = 0.0f;
+  int write_pos = 0;
+  for (int i = 0; i < ops; i++) {
+    if ((i & 255) == 0) {
+      float t = 0.01f + 149.0f * (float)((i >> 8) % 97) / 97.0f;
+      read_head.Set(t, 0.8f, 0.5f);
+    }
+    acc += read_head.Process((float)write_pos);
+    if (++write_pos >= (int)legacy_mem.size())
+      write_pos = 0;
+  }
+  return acc;
+}
+
+void SetupSvf() { svf.Init(kSampleRate); }
+float RunSvf(int ops) {
+  uint32_t seed = 7;
+  float acc = 0.0f;
+  for (int i = 0; i < ops; i++) {
+    svf.Process(NoiseSample(seed) * 0.1f);
+    acc += svf.Band();
+  }
+  return acc;
+}
+
+// SetFreq + SetRes + Process, the per-sample pattern in Massive and the
+// resonator voices.
+float RunSvfSetParams(int ops) {
+  uint32_t seed = 8;
+  float acc = 0.0f;
+  for (int i = 0; i < ops; i++) {
+    int k = i & 7;
+    float gain = ((i >> 3) & 1023) / 1023.0f;
+    svf.SetFreq(80.0f * powf(2.0f, (float)k));
+    svf.SetRes(0.1f + gain * 0.7f);
+    svf.Process(NoiseSample(seed) * 0.1f);
+    acc += svf.Band();
+  }
+  return acc;
+}
+
+void SetupPitchShifter() {
+  shifter->Init(kSampleRate);
+  shifter->SetTransposition(12.0f);
+  shifter->SetDelSize(1600);
+}
+float RunPitchShifter(int ops) {
+  uint32_t seed = 9;
+  float acc = 0.0f;
+  for (int i = 0; i < ops; i++) {
+    float x = NoiseSample(seed);
+    acc += shifter->Process(x);
+  }
+  return acc;
+}
+
+// fast_math.h against the libm calls it replaces, same argument sweeps
+template <float (*F)(float)> float RunUnary(float lo, float hi, int ops) {
+  float acc = 0.0f;
+  float x = lo, step = (hi - lo) / 4096.0f;
+  for (int i = 0; i < ops; i++) {
+    acc += F(x);
+    x += step;
+    if (x > hi)
+      x = lo;
+  }
+  return acc;
+}
+float LibSin(float x) { return sinf(x); }
+float LibAtan(float x) { return atanf(x); }
+float LibExp(float x) { return expf(x); }
+float LibPow(float x) { return powf(x, 0.25f); }
+float FastPowQuarter(float x) { return oam::FastPow(x, 0.25f); }
+float RunSinf(int ops) { return RunUnary<LibSin>(-3.2f, 3.2f, ops); }
+float RunFastSin(int ops) { return RunUnary<oam::FastSin>(-3.2f, 3.2f, ops); }
+float RunAtanf(int ops) { return RunUnary<LibAtan>(-10.0f, 10.0f, ops); }
+float RunFastAtan(int ops) { return RunUnary<oam::FastAtan>(-10.0f, 10.0f, ops); }
+float RunExpf(int ops) { return RunUnary<LibExp>(-2.0f, 0.0f, ops); }
+float RunFastExp(int ops) { return RunUnary<oam::FastExp>(-2.0f, 0.0f, ops); }
+float RunPowf(int ops) { return RunUnary<LibPow>(0.0f, 1.0f, ops); }
+float RunFastPow(int ops) { return RunUnary<FastPowQuarter>(0.0f, 1.0f, ops); }
+
+const Kernel kKernels[] = {
+    {"RingBuffer::Read", SetupRingRead, RunRingRead},
+    {"OmniAllpass::Process", SetupOmniAllpass, RunOmniAllpass},
+    {"SimpleAllpass::Process", SetupSimpleAllpass, RunSimpleAllpass},
+    {"OmniOnePole::Process", SetupOnePole, RunOnePole},
+    {"OmniOnePole::SetFreq+Process", SetupOnePole, RunOnePoleSetFreq},
+    {"LegacyHelpers::softClip", SetupNone, RunSoftClip},
+    {"ReadHead::Process", SetupReadHead, RunReadHead},
+    {"Svf::Process", SetupSvf, RunSvf},
+    {"Svf::SetFreq+SetRes+Process", SetupSvf, RunSvfSetParams},
+    {"PitchShifter::Process", SetupPitchShifter, RunPitchShifter},
+    {"sinf", SetupNone, RunSinf},
+    {"oam::FastSin", SetupNone, RunFastSin},
+    {"atanf", SetupNone, RunAtanf},
+    {"oam::FastAtan", SetupNone, RunFastAtan},
+    {"expf", SetupNone, RunExpf},
+    {"oam::FastExp", SetupNone, RunFastExp},
+    {"powf(x,0.25)", SetupNone, RunPowf},
+    {"oam::FastPow(x,0.25)", SetupNone, RunFastPow},
+};
+
+// --- fast_math.h accuracy, bounds as documented in the header ---
+struct AccuracyCase {
+  const char *name;
+  bool relative;
+  double bound;
+  float lo, hi;
+  float (*fast)(float);
+  double (*exact)(double);
+};
+
+// Pow is checked over its documented range of exponents as well
+float pow_exponent;
+float FastPowY(float x) { return oam::FastPow(x, pow_exponent); }
+double ExactPowY(double x) { return pow(x, (double)pow_exponent); }
+
+const AccuracyCase kAccuracy[] = {
+    {"FastExp2", true, 3e-7, -126.0f, 126.0f, oam::FastExp2,
+     [](double x) { return exp2(x); }},
+    {"FastExp", true, 1e-6, -10.0f, 10.0f, oam::FastExp,
+     [](double x) { return exp(x); }},
+    {"FastLog2", false, 1e-6, 1e-30f, 1e30f, oam::FastLog2,
+     [](double x) { return log2(x); }},
+    {"FastSin", false, 5e-7, -1000.0f, 1000.0f, oam::FastSin,
+     [](double x) { return sin((double)(float)x); }},
+    {"FastAtan", false, 3e-7, -1e6f, 1e6f, oam::FastAtan,
+     [](double x) { return atan(x); }},
+};
+
+// Returns the worst error of `c` over its range. Log2 is swept
+// geometrically, everything else linearly.
+double MaxError(const AccuracyCase &c) {
+  const int kPoints = 1 << 20;
+  double worst = 0.0;
+  double ratio = (double)c.hi / c.lo;
+  bool geometric = c.lo > 0.0f && ratio > 1e6;
+  for (int i = 0; i <= kPoints; i++) {
+    double t = (double)i / kPoints;
+    float x = geometric ? (float)(c.lo * pow(ratio, t))
+                        : (float)(c.lo + (c.hi - c.lo) * t);
+    double ref = c.exact(x);
+    double err = fabs((double)c.fast(x) - ref);
+    // Absolute errors are relative once the result is over 1
+    err /= c.relative ? fabs(ref) : std::max(1.0, fabs(ref));
+    if (err > worst)
+      worst = err;
+  }
+  return worst;
+}
+
+// Prints the table, returns the number of broken bounds
+int CheckAccuracy() {
+  int failures = 0;
+  printf("%-30s %9s %9s\n", "fast_math", "max err", "bound");
+  auto report = [&](const char *name, double err, double bound) {
+    bool bad = !(err <= bound);
+    failures += bad;
+    printf("%-30s %9.2g %9.2g%s\n", name, err, bound, bad ? "  FAIL" : "");
+  };
+  for (const AccuracyCase &c : kAccuracy)
+    report(c.name, MaxError(c), c.bound);
+
+  double worst = 0.0;
+  for (float y = -4.0f; y <= 4.0f; y += 0.125f) {
+    pow_exponent = y;
+    AccuracyCase c = {"", true, 0.0, 1e-3f, 4.0f, FastPowY, ExactPowY};
+    worst = std::max(worst, MaxError(c));
+  }
+  report("FastPow", worst, 4e-6);
+  printf("\n");
+  return failures;
+}
+
+double TimeKernel(const Kernel &k) {
+  k.setup();
+  sink = k.run(kOpsPerRun / 4); // warm caches and branch predictors
+  double best = 1e30;
+  for (int r = 0; r < kRuns; r++) {
+    auto t0 = std::chrono::steady_clock::now();
+    sink = k.run(kOpsPerRun);
+    auto t1 = std::chrono::steady_clock::now();
+    double ns = std::chrono::duration<double, std::nano>(t1 - t0).count();
+    if (ns < best)
+      best = ns;
+  }
+  return best / kOpsPerRun;
+}
+
+bool LoadBaseline(const char *path, std::map<std::string, double> &out) {
+  std::ifstream f(path);
+  if (!f)
+    return false;
+  std::string name;
+  double ns;
+  while (f >> name >> ns)
+    out[name] = ns;
+  return true;
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+  const char *save_path = nullptr;
+  const char *baseline_path = nullptr;
+  const char *filter = nullptr;
+  double margin = 0.15;
+
+  for (int i = 1; i < argc; i++) {
+    std::string a = argv[i];
+    bool has_val = i + 1 < argc;
+    if (a == "--save" && has_val)
+      save_path = argv[++i];
+    else if (a == "--baseline" && has_val)
+      baseline_path = argv[++i];
+    else if (a == "--margin" && has_val)
+      margin = atof(argv[++i]);
+    else if (a == "--filter" && has_val)
+      filter = argv[++i];
+    else {
+      fprintf(stderr, "usage: microbench [--save file] [--baseline file] "
+                      "[--margin 0.15] [--filter text]\n");
+      return 2;
+    }
+  }
+
+  std::map<std::string, double> baseline;
+  if (baseline_path && !LoadBaseline(baseline_path, baseline)) {
+    fprintf(stderr, "could not read baseline %s\n", baseline_path);
+    return 1;
+  }
+
+  FILE *save = nullptr;
+  if (save_path && !(save = fopen(save_path, "w"))) {
+    fprintf(stderr, "could not write %s\n", save_path);
+    return 1;
+  }
+
+  if (CheckAccuracy()) {
+    printf("fast_math.h is outside its documented error bounds\n");
+    return 1;
+  }
+
+  int regressions = 0;
+  printf("%-30s %9s %9s %8s\n", "kernel", "ns/op", "baseline", "change");
+  for (const Kernel &k : kKernels) {
+    if (filter && !strstr(k.name, filter))
+      continue;
+    double ns = TimeKernel(k);
+    if (save)
+      fprintf(save, "%s %.3f\n", k.name, ns);
+
+    auto it = baseline.find(k.name);
+    if (it == baseline.end()) {
+      printf("%-30s %9.2f %9s %8s\n", k.name, ns, "-", "-");
+      continue;
+    }
+    double change = ns / it->second - 1.0;
+    bool slow = change > margin;
+    regressions += slow;
+    printf("%-30s %9.2f %9.2f %+7.1f%%%s\n", k.name, ns, it->second,
+           change * 100.0, slow ? "  REGRESSION" : "");
+  }
+  if (save)
+    fclose(save);
+
+  if (regressions) {
+    printf("%d kernel(s) slower than baseline by more than %.0f%%\n",
+           regressions, margin * 100.0);
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,308 @@
+/**
+ * Offline renderer and per-mode CPU benchmark for the Omnibus engines.
+ *
+ *   omnibus_render [--mode studio|shimmer|massive|resonator|legacy|superfdn|all]
+ *                  [--in input.wav] [--out prefix] [--script controls.txt]
+ *                  [--seconds 10] [--block mode|n] [--m7-slowdown 15]
+ *                  [--layout planar|interleaved|both] [--rate 48000|96000]
+ *
+ * Without --in a synthetic test signal (noise bursts and plucks) is used,
+ * at --rate (48000 by default); with --in the file's rate is used.
+ * With --out each mode is written to <prefix>_<mode>.wav, the interleaved
+ * run to <prefix>_<mode>_il.wav.
+ *
+ * --layout picks the buffers the engines run on: separate L/R (the default
+ * firmware build) or interleaved L/R frames (INTERLEAVED=1). "both" times
+ * each mode both ways and shows the interleaved change against planar.
+ *
+ * Script lines are "<seconds> <control> <value>", '#' starts a comment.
+ * Controls: time, mod, decay, dry, sliders (all eight), slider1..slider8,
+ * mode (switch engines at runtime, 0..4 in the firmware's order), strike
+ * (a gate 2 trigger, any value above 0).
+ * Values are applied at the next control tick, every ControlBlocks()
+ * blocks as the callback's control scheduler.
+ *
+ * --block mode (the default) runs each mode at its firmware block size,
+ * BlockSizeFor() in engine_harness.h; a number runs every mode at it.
+ *
+ * The M7 estimate scales host time by --m7-slowdown (how many times slower
+ * the 480 MHz Cortex-M7 runs this code than the host). Calibrate it against
+ * the on-device numbers for one mode; the default is a rough guess.
+ */
+#include "engine_harness.h"
+#include "wav.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace oam::host;
+
+namespace {
+
+const float kM7ClockHz = 480e6f;
+
+struct ScriptEvent {
+  float time;
+  std::string control;
+  float value;
+};
+
+bool LoadScript(const char *path, std::vector<ScriptEvent> &events) {
+  std::ifstream f(path);
+  if (!f)
+    return false;
+  std::string line;
+  int line_no = 0;
+  while (std::getline(f, line)) {
+    line_no++;
+    size_t hash = line.find('#');
+    if (hash != std::string::npos)
+      line.resize(hash);
+    std::istringstream ss(line);
+    ScriptEvent e;
+    if (!(ss >> e.time))
+      continue;
+    if (!(ss >> e.control >> e.value) || !Controls().Set(e.control, e.value)) {
+      fprintf(stderr, "%s:%d: bad script line\n", path, line_no);
+      return false;
+    }
+    events.push_back(e);
+  }
+  return true;
+}
+
+void MakeTestSignal(StereoBuffer &buf, float seconds) {
+  size_t frames = (size_t)(seconds * buf.sample_rate);
+  buf.Resize(frames);
+  uint32_t seed = 12345;
+  size_t period = (size_t)(buf.sample_rate * 0.75f);
+  for (size_t i = 0; i < frames; i++) {
+    size_t t = i % period;
+    float env = expf(-(float)t / (buf.sample_rate * 0.05f));
+    seed = seed * 1664525u + 1013904223u;
+    float noise = ((seed >> 9) / 8388608.0f) * 2.0f - 1.0f;
+    float pluck = sinf(2.0f * PI_F * 220.0f * (float)t / buf.sample_rate);
+    float s = ((i / period) & 1) ? pluck : noise;
+    buf.left[i] = 0.5f * env * s;
+    buf.right[i] = 0.5f * env * s;
+  }
+}
+
+struct Result {
+  double ns_per_sample;
+  double p999_block_ns; // host max is dominated by preemption, not the DSP
+};
+
+Result RunMode(EngineHarness &harness, int mode, const StereoBuffer &in,
+               StereoBuffer &out, const std::vector<ScriptEvent> &script,
+               size_t block, bool interleaved) {
+  harness.Init(mode, in.sample_rate);
+  out.sample_rate = in.sample_rate;
+  out.Resize(in.Frames());
+
+  Controls ctl;
+  size_t next_event = 0;
+  size_t control_period = block * ControlBlocks(block, in.sample_rate);
+  size_t next_control = 0;
+  harness.UpdateControls(ctl);
+
+  std::vector<float> in_l(block), in_r(block), out_l(block), out_r(block);
+  std::vector<float> in_il(2 * block), out_il(2 * block);
+  std::vector<double> block_ns;
+  double total_ns = 0.0;
+  for (size_t pos = 0; pos < in.Frames(); pos += block) {
+    if (pos >= next_control) {
+      float now = pos / in.sample_rate;
+      while (next_event < script.size() && script[next_event].time <= now) {
+        ctl.Set(script[next_event].control, script[next_event].value);
+        next_event++;
+      }
+      harness.UpdateControls(ctl);
+      ctl.strike = false; // an edge, not a level
+      next_control += control_period;
+    }
+
+    // The DMA buffers are always full blocks, pad the tail with silence
+    size_t n = std::min(block, in.Frames() - pos);
+    std::fill(in_l.begin(), in_l.end(), 0.0f);
+    std::fill(in_r.begin(), in_r.end(), 0.0f);
+    std::copy(&in.left[pos], &in.left[pos] + n, in_l.begin());
+    std::copy(&in.right[pos], &in.right[pos] + n, in_r.begin());
+    if (interleaved) {
+      for (size_t i = 0; i < block; i++) {
+        in_il[2 * i] = in_l[i];
+        in_il[2 * i + 1] = in_r[i];
+      }
+    }
+
+    auto t0 = std::chrono::steady_clock::now();
+    if (interleaved)
+      harness.ProcessBlock<2>(in_il.data(), in_il.data() + 1, out_il.data(),
+                              out_il.data() + 1, block);
+    else
+      harness.ProcessBlock(in_l.data(), in_r.data(), out_l.data(),
+                           out_r.data(), block);
+    auto t1 = std::chrono::steady_clock::now();
+    double ns = std::chrono::duration<double, std::nano>(t1 - t0).count();
+    total_ns += ns;
+    block_ns.push_back(ns);
+
+    if (interleaved) {
+      for (size_t i = 0; i < n; i++) {
+        out_l[i] = out_il[2 * i];
+        out_r[i] = out_il[2 * i + 1];
+      }
+    }
+    std::copy(out_l.begin(), out_l.begin() + n, &out.left[pos]);
+    std::copy(out_r.begin(), out_r.begin() + n, &out.right[pos]);
+  }
+  size_t blocks = block_ns.size();
+  std::sort(block_ns.begin(), block_ns.end());
+  double p999 = blocks ? block_ns[(blocks - 1) * 999 / 1000] : 0.0;
+  return {total_ns / (double)(blocks * block), p999};
+}
+
+void Usage() {
+  fprintf(stderr, "usage: omnibus_render [--mode <name>|all] [--in file.wav] "
+                  "[--out prefix] [--script file]\n"
+                  "                      [--seconds s] [--block mode|n] "
+                  "[--m7-slowdown x]\n"
+                  "                      [--layout planar|interleaved|both] "
+                  "[--rate hz]\n");
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+  std::string mode_arg = "all";
+  const char *in_path = nullptr;
+  const char *out_prefix = nullptr;
+  const char *script_path = nullptr;
+  float seconds = 10.0f;
+  size_t block = 0; // BlockSizeFor(mode)
+  float m7_slowdown = 15.0f;
+  std::string layout = "planar";
+  float rate = 48000.0f;
+
+  for (int i = 1; i < argc; i++) {
+    std::string a = argv[i];
+    bool has_val = i + 1 < argc;
+    if (a == "--mode" && has_val)
+      mode_arg = argv[++i];
+    else if (a == "--in" && has_val)
+      in_path = argv[++i];
+    else if (a == "--out" && has_val)
+      out_prefix = argv[++i];
+    else if (a == "--script" && has_val)
+      script_path = argv[++i];
+    else if (a == "--seconds" && has_val)
+      seconds = (float)atof(argv[++i]);
+    else if (a == "--block" && has_val && !strcmp(argv[i + 1], "mode"))
+      block = 0, i++;
+    else if (a == "--block" && has_val)
+      block = (size_t)std::max(1, atoi(argv[++i]));
+    else if (a == "--m7-slowdown" && has_val)
+      m7_slowdown = (float)atof(argv[++i]);
+    else if (a == "--layout" && has_val)
+      layout = argv[++i];
+    else if (a == "--rate" && has_val)
+      rate = (float)atof(argv[++i]);
+    else {
+      Usage();
+      return 2;
+    }
+  }
+
+  std::vector<int> modes;
+  if (mode_arg == "all") {
+    for (int m = 0; m < HOST_MODE_LAST; m++)
+      modes.push_back(m);
+  } else if (ModeFromName(mode_arg) >= 0) {
+    modes.push_back(ModeFromName(mode_arg));
+  } else {
+    fprintf(stderr, "unknown mode '%s'\n", mode_arg.c_str());
+    return 2;
+  }
+  std::vector<bool> layouts;
+  if (layout == "planar" || layout == "both")
+    layouts.push_back(false);
+  if (layout == "interleaved" || layout == "both")
+    layouts.push_back(true);
+  if (layouts.empty()) {
+    fprintf(stderr, "unknown layout '%s'\n", layout.c_str());
+    return 2;
+  }
+  if (block > 1024) {
+    fprintf(stderr, "block size must be 1..1024\n");
+    return 2;
+  }
+
+  StereoBuffer input;
+  if (in_path) {
+    if (!ReadWav(in_path, input)) {
+      fprintf(stderr, "could not read %s\n", in_path);
+      return 1;
+    }
+  } else {
+    input.sample_rate = rate;
+    MakeTestSignal(input, seconds);
+  }
+
+  std::vector<ScriptEvent> script;
+  if (script_path && !LoadScript(script_path, script))
+    return 1;
+
+  StereoBuffer output;
+
+  float budget_cycles = kM7ClockHz / input.sample_rate;
+  printf("%zu frames @ %.0f Hz, M7 budget %.0f cycles/sample\n",
+         input.Frames(), input.sample_rate, budget_cycles);
+  printf("%-13s %5s %10s %14s %9s %9s %10s\n", "mode", "block", "ns/sample",
+         "M7 cyc/sample", "M7 load", "headroom", "p99.9 blk");
+  for (int mode : modes) {
+    size_t mode_block = block ? block : BlockSizeFor(mode);
+    double planar_ns = 0.0;
+    for (bool interleaved : layouts) {
+      // A fresh harness per run: re-Init() leaves some legacy state (slews,
+      // read heads) from the previous run, which would skew the comparison
+      EngineHarness *harness = new EngineHarness();
+      Result r = RunMode(*harness, mode, input, output, script, mode_block,
+                         interleaved);
+      delete harness;
+      double m7_cycles = r.ns_per_sample * m7_slowdown * (kM7ClockHz * 1e-9);
+      double load = m7_cycles / budget_cycles;
+      double p999_cycles = r.p999_block_ns / (double)mode_block *
+                           m7_slowdown * (kM7ClockHz * 1e-9);
+      std::string name = ModeName(mode);
+      if (interleaved)
+        name += " il";
+      printf("%-13s %5zu %10.1f %14.0f %8.1f%% %8.1f%% %9.1f%%",
+             name.c_str(), mode_block, r.ns_per_sample, m7_cycles,
+             load * 100.0, (1.0 - load) * 100.0,
+             p999_cycles / budget_cycles * 100.0);
+      if (interleaved && planar_ns > 0.0)
+        printf("  %+.1f%% vs planar",
+               (r.ns_per_sample / planar_ns - 1.0) * 100.0);
+      else
+        planar_ns = r.ns_per_sample;
+      printf("\n");
+
+      if (out_prefix) {
+        std::string path = std::string(out_prefix) + "_" + ModeName(mode) +
+                           (interleaved ? "_il" : "") + ".wav";
+        if (!WriteWav(path.c_str(), output)) {
+          fprintf(stderr, "could not write %s\n", path.c_str());
+          return 1;
+        }
+      }
+    }
+  }
+  return 0;
+}
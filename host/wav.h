@@ -0,0 +1,131 @@
+#pragma once
+/**
+ * Minimal RIFF/WAVE reader and writer for the host tools.
+ * Reads 16/24/32-bit PCM and 32-bit float, mono or stereo.
+ * Writes 32-bit float stereo.
+ */
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+namespace oam {
+namespace host {
+
+struct StereoBuffer {
+  float sample_rate = 48000.0f;
+  std::vector<float> left, right;
+  size_t Frames() const { return left.size(); }
+  void Resize(size_t frames) {
+    left.assign(frames, 0.0f);
+    right.assign(frames, 0.0f);
+  }
+};
+
+inline uint32_t ReadLe(const uint8_t *p, int bytes) {
+  uint32_t v = 0;
+  for (int i = 0; i < bytes; i++)
+    v |= (uint32_t)p[i] << (8 * i);
+  return v;
+}
+
+inline bool ReadWav(const char *path, StereoBuffer &out) {
+  FILE *f = fopen(path, "rb");
+  if (!f)
+    return false;
+  std::vector<uint8_t> data;
+  uint8_t chunk[4096];
+  size_t n;
+  while ((n = fread(chunk, 1, sizeof(chunk), f)) > 0)
+    data.insert(data.end(), chunk, chunk + n);
+  fclose(f);
+
+  if (data.size() < 12 || memcmp(&data[0], "RIFF", 4) ||
+      memcmp(&data[8], "WAVE", 4))
+    return false;
+
+  int format = 0, channels = 0, bits = 0;
+  const uint8_t *samples = nullptr;
+  size_t sample_bytes = 0;
+  size_t pos = 12;
+  while (pos + 8 <= data.size()) {
+    uint32_t size = ReadLe(&data[pos + 4], 4);
+    const uint8_t *body = &data[pos + 8];
+    if (pos + 8 + size > data.size())
+      size = (uint32_t)(data.size() - pos - 8);
+    if (!memcmp(&data[pos], "fmt ", 4) && size >= 16) {
+      format = (int)ReadLe(body, 2);
+      channels = (int)ReadLe(body + 2, 2);
+      out.sample_rate = (float)ReadLe(body + 4, 4);
+      bits = (int)ReadLe(body + 14, 2);
+      if (format == 0xFFFE && size >= 26) // WAVE_FORMAT_EXTENSIBLE
+        format = (int)ReadLe(body + 24, 2);
+    } else if (!memcmp(&data[pos], "data", 4)) {
+      samples = body;
+      sample_bytes = size;
+    }
+    pos += 8 + size + (size & 1);
+  }
+  if (!samples || channels < 1 || (format != 1 && format != 3))
+    return false;
+
+  int bytes = bits / 8;
+  size_t frames = sample_bytes / (bytes * channels);
+  out.Resize(frames);
+  for (size_t i = 0; i < frames; i++) {
+    for (int c = 0; c < 2; c++) {
+      const uint8_t *p =
+          samples + (i * channels + (c < channels ? c : 0)) * bytes;
+      float v = 0.0f;
+      if (format == 3 && bits == 32) {
+        uint32_t u = ReadLe(p, 4);
+        memcpy(&v, &u, 4);
+      } else if (bits == 16) {
+        v = (int16_t)ReadLe(p, 2) / 32768.0f;
+      } else if (bits == 24) {
+        int32_t s = (int32_t)(ReadLe(p, 3) << 8) >> 8;
+        v = s / 8388608.0f;
+      } else if (bits == 32) {
+        v = (int32_t)ReadLe(p, 4) / 2147483648.0f;
+      }
+      (c == 0 ? out.left : out.right)[i] = v;
+    }
+  }
+  return true;
+}
+
+inline void WriteLe(FILE *f, uint32_t v, int bytes) {
+  for (int i = 0; i < bytes; i++)
+    fputc((v >> (8 * i)) & 0xff, f);
+}
+
+inline bool WriteWav(const char *path, const StereoBuffer &in) {
+  FILE *f = fopen(path, "wb");
+  if (!f)
+    return false;
+  uint32_t data_bytes = (uint32_t)(in.Frames() * 2 * 4);
+  fwrite("RIFF", 1, 4, f);
+  WriteLe(f, 36 + data_bytes, 4);
+  fwrite("WAVEfmt ", 1, 8, f);
+  WriteLe(f, 16, 4);
+  WriteLe(f, 3, 2); // IEEE float
+  WriteLe(f, 2, 2);
+  WriteLe(f, (uint32_t)in.sample_rate, 4);
+  WriteLe(f, (uint32_t)in.sample_rate * 8, 4);
+  WriteLe(f, 8, 2);
+  WriteLe(f, 32, 2);
+  fwrite("data", 1, 4, f);
+  WriteLe(f, data_bytes, 4);
+  for (size_t i = 0; i < in.Frames(); i++) {
+    uint32_t u;
+    memcpy(&u, &in.left[i], 4);
+    WriteLe(f, u, 4);
+    memcpy(&u, &in.right[i], 4);
+    WriteLe(f, u, 4);
+  }
+  fclose(f);
+  return true;
+}
+
+} // namespace host
+} // namespace oam
@@ -1,7 +1,13 @@
 #pragma once
 #include "daisysp.h"
+#include "dsp_profiler.h"
+#include "fast_math.h"
+#include "mdma_prefetch.h"
 #include <algorithm>
 #include <cmath>
+#if !defined(STM32H750xx)
+#include <cassert>
+#endif
 
 namespace oam {
 namespace legacy {
@@ -12,6 +18,42 @@ inline float clamp(float x, float a, float b) {
 
 inline float s_mix(float x, float a, float b) { return x * (1 - x) + b * x; }
 
+// --- Delay memory format ---
+// Float by default. Build with LEGACY_Q15=1 (OAM_LEGACY_Q15) to store Q15
+// instead: half the SDRAM traffic per tap and twice the delay time in the
+// same memory, at 16-bit resolution. Everything written is already limited
+// to +-1 by the feedback limiter.
+#ifdef OAM_LEGACY_Q15
+typedef int16_t Sample;
+static constexpr float kMaxDelaySeconds = 300.0f;
+inline Sample PackSample(float x) {
+  x = clamp(x, -1.0f, 32767.0f / 32768.0f) * 32768.0f;
+  return (Sample)(int)(x + (x >= 0.0f ? 0.5f : -0.5f));
+}
+inline float UnpackSample(Sample s) { return (float)s * (1.0f / 32768.0f); }
+#else
+typedef float Sample;
+static constexpr float kMaxDelaySeconds = 150.0f;
+inline Sample PackSample(float x) { return x; }
+inline float UnpackSample(Sample s) { return s; }
+#endif
+
+// Longest run the engines process as one block, longer callbacks are split
+static constexpr int kMaxBlock = 128;
+
+// --- Read-head prefetch ---
+// At the end of each block every head queues copies of the block-sized
+// windows its taps will read next, into fast memory (DTCM on the Daisy),
+// and the copies run while the main loop does. Blocks over kMaxBlock just
+// read SDRAM.
+static constexpr int kPrefetchSlots = 2; // the two crossfade taps
+static constexpr size_t kPrefetchHeadSamples =
+    kPrefetchSlots * kMaxBlock;
+// Both channels, 8 heads each
+static constexpr size_t kPrefetchWindowSamples = 2 * 8 * kPrefetchHeadSamples;
+// A window that wraps around the buffer end needs two copies
+static constexpr size_t kPrefetchMaxNodes = 2 * 8 * kPrefetchSlots * 2;
+
 // --- Helpers from dsp.h ---
 // (Assuming standard math usage).
 
@@ -20,7 +62,7 @@ struct LegacyHelpers {
                         float kneeCurve = 5.0f) {
     float linPart = clamp(x, -kneeStart, kneeStart);
     float clipPart = x - linPart;
-    clipPart = atanf(clipPart * kneeCurve) / kneeCurve;
+    clipPart = oam::FastAtan(clipPart * kneeCurve) / kneeCurve;
     return linPart + clipPart;
   }
 
@@ -29,11 +71,11 @@ struct LegacyHelpers {
     if (s > 0.5f) {
       s = (s - 0.5f) * 2.0f;
       s = s * e + 1.0f;
-      return 1.0f - powf(1.0f - x, s);
+      return 1.0f - oam::FastPow(1.0f - x, s);
     } else if (s < 0.5f) {
       s = 1.0f - (s * 2.0f);
       s = s * e + 1.0f;
-      return powf(x, s);
+      return oam::FastPow(x, s);
     } else {
       return x;
     }
@@ -46,11 +88,16 @@ struct LegacyHelpers {
   }
 
   static int seconds_to_samples(float x, float sr) { return (int)(x * sr); }
+  // x in [-size, 2 size): every caller is at most one turn out, so one
+  // conditional add each way wraps it without a loop. That needs the delay
+  // times within maxDelay, i.e. the time control clamped to 0..1; host
+  // builds check it.
   static int wrap_buffer_index(int x, int size) {
-    while (x >= size)
-      x -= size;
-    while (x < 0)
-      x += size;
+#if !defined(STM32H750xx)
+    assert(x >= -size && x < 2 * size);
+#endif
+    x += x < 0 ? size : 0;
+    x -= x >= size ? size : 0;
     return x;
   }
 };
@@ -59,7 +106,9 @@ class Slew {
 public:
   float lastVal = 0.0f;
   float coef = 0.001f;
-  void Init(float c = 0.001f) { coef = c; }
+  // `c` is the per-sample coefficient at 48 kHz, scaled to keep the time
+  // constant at other rates
+  void Init(float sr, float c = 0.001f) { coef = c * (48000.0f / sr); }
   float Process(float x) {
     lastVal = lastVal + (x - lastVal) * coef;
     return lastVal;
@@ -89,7 +138,7 @@ class LoudnessDetector {
 public:
   Slew slew;
   float lastVal = 0;
-  void Init() { slew.Init(); }
+  void Init(float sr) { slew.Init(sr); }
   float Get() { return this->lastVal; }
   float Process(float x) {
     lastVal = slew.Process(fabsf(x));
@@ -100,8 +149,12 @@ public:
 class ReadHead {
 public:
   LoudnessDetector loudness;
-  float *buffer;
+  Sample *buffer;
   int bufferSize;
+  // buffer[validLen...] has not been written since boot and reads as
+  // silence, so the memory never needs clearing. Kept up to date by the
+  // engine; Init() marks the whole buffer valid.
+  int validLen;
   float delayA = 0.0f, delayB = 0.0f, targetDelay = -1.0f;
   float ampA = 0.0f, ampB = 0.0f, targetAmp = -1.0f;
   float sampleRate;
@@ -109,13 +162,24 @@ public:
   float delta;
   float blurAmount;
 
-  void Init(float sr, float *buf, int size) {
+  // Prefetched copies of buffer[winStart[s]...] (wrapping), winLen[s] long.
+  // A window never overlaps samples written during the block it is used
+  // in, so any index that falls inside one can be read from it.
+  Sample *win[kPrefetchSlots] = {nullptr, nullptr};
+  int winStart[kPrefetchSlots] = {0, 0};
+  int winLen[kPrefetchSlots] = {0, 0};
+
+  oam::XorShift32 rng; // blur
+
+  void Init(float sr, Sample *buf, int size, uint32_t seed) {
     sampleRate = sr;
     delta = 5.0f / sr;
     buffer = buf;
     bufferSize = size;
+    validLen = size;
     blurAmount = 0.0f;
-    loudness.Init();
+    rng.Seed(seed);
+    loudness.Init(sr);
   }
 
   void Set(float delay, float amp, float blur = 0) {
@@ -126,20 +190,7 @@ public:
 
   float Process(float writeHeadPosition) {
     if (phase >= 1.0f && (targetDelay >= 0.0f || targetAmp >= 0.0f)) {
-      if (targetDelay >= 0.0f) {
-        delayA = delayB;
-        delayB = targetDelay;
-        targetDelay = -1.0f;
-      }
-      if (targetAmp >= 0.0f) {
-        ampA = ampB;
-        ampB = targetAmp;
-        targetAmp = -1.0f;
-      }
-      phase = 0.0f;
-      // Simple random for blur
-      float r = ((float)rand() / (float)RAND_MAX) * 2.0f - 1.0f;
-      delta = (5.0f + (r * blurAmount)) / sampleRate;
+      Retarget();
     }
 
     int idxA = LegacyHelpers::wrap_buffer_index(
@@ -151,8 +202,8 @@ public:
             LegacyHelpers::seconds_to_samples(delayB, sampleRate),
         bufferSize);
 
-    float outA = buffer[idxA];
-    float outB = buffer[idxB];
+    float outA = Tap(idxA);
+    float outB = Tap(idxB);
 
     float output = ((1.0f - phase) * outA) + (phase * outB);
     float outputAmp = ((1.0f - phase) * ampA) + (phase * ampB);
@@ -160,6 +211,172 @@ public:
     phase = phase <= 1.0f ? phase + delta : 1.0f;
     return loudness.Process(output) * outputAmp;
   }
+
+  void Retarget() {
+    if (targetDelay >= 0.0f) {
+      delayA = delayB;
+      delayB = targetDelay;
+      targetDelay = -1.0f;
+    }
+    if (targetAmp >= 0.0f) {
+      ampA = ampB;
+      ampB = targetAmp;
+      targetAmp = -1.0f;
+    }
+    phase = 0.0f;
+    delta = (5.0f + (rng.Bipolar() * blurAmount)) / sampleRate;
+  }
+
+  // True if every tap the next `size` samples can use reads only samples
+  // written before them, so the block can be computed ahead of the writes.
+  bool CanProcessBlock(int size) const {
+    const float d[3] = {delayA, delayB, targetDelay};
+    for (int t = 0; t < 3; t++) {
+      if (d[t] < 0.0f)
+        continue;
+      int ds = LegacyHelpers::seconds_to_samples(d[t], sampleRate);
+      if (ds < size || ds >= bufferSize)
+        return false;
+    }
+    return true;
+  }
+
+  // Finds where in the next `size` samples Process() would take the pending
+  // target, replaying its phase steps.
+  int PlanRetarget(int size) const {
+    if (targetDelay < 0.0f && targetAmp < 0.0f)
+      return -1;
+    // Far from the end of the crossfade: the margin covers the rounding of
+    // `size` additions.
+    if (phase + (float)size * delta + 1e-4f < 1.0f)
+      return -1;
+    float p = phase;
+    for (int j = 0; j < size; j++) {
+      if (p >= 1.0f)
+        return j;
+      p = p <= 1.0f ? p + delta : 1.0f;
+    }
+    return -1;
+  }
+
+  // Block version of Process(): adds the next `size` outputs to `acc`, the
+  // write head being at `w0` for the first. Needs CanProcessBlock().
+  // Returns the sample at which it took a new target, or -1.
+  int ProcessBlock(int w0, float *acc, int size) {
+    int at = PlanRetarget(size);
+    if (at < 0) {
+      Run(w0, acc, 0, size);
+      return -1;
+    }
+    Run(w0, acc, 0, at);
+    Retarget();
+    Run(w0, acc, at, size);
+    return at;
+  }
+
+  inline float Tap(int idx) const {
+    if (idx >= validLen)
+      return 0.0f;
+    for (int s = 0; s < kPrefetchSlots; s++) {
+      int off = LegacyHelpers::wrap_buffer_index(idx - winStart[s],
+                                                 bufferSize);
+      if (off < winLen[s])
+        return UnpackSample(win[s][off]);
+    }
+    return UnpackSample(buffer[idx]);
+  }
+
+  // Samples [j0, j1) of a block with fixed taps. Walks both taps as
+  // contiguous runs, split where either wraps or crosses validLen. Tap A is only read while it
+  // has weight: not when it is the same sample as tap B, nor at phase 1.
+  void Run(int w0, float *acc, int j0, int j1) {
+    int ia = LegacyHelpers::wrap_buffer_index(
+        w0 + j0 - LegacyHelpers::seconds_to_samples(delayA, sampleRate),
+        bufferSize);
+    int ib = LegacyHelpers::wrap_buffer_index(
+        w0 + j0 - LegacyHelpers::seconds_to_samples(delayB, sampleRate),
+        bufferSize);
+    const bool same = ia == ib;
+    int j = j0;
+    while (j < j1) {
+      int n = std::min(j1 - j, std::min(RunLength(ia), RunLength(ib)));
+      const Sample *pa = Source(ia, n);
+      const Sample *pb = Source(ib, n);
+      for (int k = 0; k < n; k++) {
+        float outB = UnpackSample(pb[k]);
+        float outA = (same || phase == 1.0f) ? outB : UnpackSample(pa[k]);
+        float output = ((1.0f - phase) * outA) + (phase * outB);
+        float outputAmp = ((1.0f - phase) * ampA) + (phase * ampB);
+        phase = phase <= 1.0f ? phase + delta : 1.0f;
+        acc[j + k] += loudness.Process(output) * outputAmp;
+      }
+      j += n;
+      ia = LegacyHelpers::wrap_buffer_index(ia + n, bufferSize);
+      ib = LegacyHelpers::wrap_buffer_index(ib + n, bufferSize);
+    }
+  }
+
+  // Samples from idx before the buffer wraps or validity changes
+  int RunLength(int idx) const {
+    return idx < validLen ? validLen - idx : bufferSize - idx;
+  }
+
+  // buffer + idx, the prefetched copy if one holds [idx, idx + n), or
+  // silence past validLen. n <= kMaxBlock.
+  const Sample *Source(int idx, int n) const {
+    static const Sample silence[kMaxBlock] = {};
+    if (idx >= validLen)
+      return silence;
+    for (int s = 0; s < kPrefetchSlots; s++) {
+      int off = LegacyHelpers::wrap_buffer_index(idx - winStart[s],
+                                                 bufferSize);
+      if (off + n <= winLen[s])
+        return win[s] + off;
+    }
+    return buffer + idx;
+  }
+
+  // Queues the windows the next `size` samples will read, the write head
+  // being at `w0` when they start. The taps are the ones Process() will
+  // use at the first sample: a pending target replaces tap B then. A tap
+  // whose window would reach into [w0, w0 + size) or past validLen stays
+  // on SDRAM, as does one retargeted mid-block.
+  void QueuePrefetch(MdmaPrefetcher &pf, int w0, int size) {
+    float d[kPrefetchSlots];
+    if (phase >= 1.0f && targetDelay >= 0.0f) {
+      d[0] = delayB;
+      d[1] = targetDelay;
+    } else {
+      d[0] = phase < 1.0f ? delayA : -1.0f;
+      d[1] = delayB;
+    }
+    int prev = -1;
+    for (int s = 0; s < kPrefetchSlots; s++) {
+      winLen[s] = 0;
+      if (!win[s] || d[s] < 0.0f)
+        continue;
+      int ds = LegacyHelpers::seconds_to_samples(d[s], sampleRate);
+      if (ds < size || ds > bufferSize - size || ds == prev)
+        continue;
+      prev = ds;
+      int start = LegacyHelpers::wrap_buffer_index(w0 - ds, bufferSize);
+      if (validLen < bufferSize && start + size > validLen)
+        continue;
+      int first = std::min(size, bufferSize - start);
+      if (!pf.Queue(win[s], buffer + start, first * sizeof(Sample)))
+        continue;
+      if (first < size &&
+          !pf.Queue(win[s] + first, buffer, (size - first) * sizeof(Sample)))
+        continue;
+      winStart[s] = start;
+      winLen[s] = size;
+    }
+  }
+
+  void DropPrefetch() {
+    for (int s = 0; s < kPrefetchSlots; s++)
+      winLen[s] = 0;
+  }
 };
 
 class LegacyMonoEngine {
@@ -167,8 +384,9 @@ public:
   ReadHead readHeads[8];
   LoudnessDetector loudness;
   float sampleRate;
-  float *buffer;
+  Sample *buffer;
   int bufferSize;
+  int validLen; // samples written since Init, see ReadHead::validLen
   int writeHeadPosition;
   float dryAmp, feedback, blur;
 
@@ -177,22 +395,23 @@ public:
   daisysp::Compressor compressor;
   // Skipping DC Blocker for simplicity/size, compressor handles dynamics
 
-  void Init(float sr, float maxDelay, float *buf) {
+  // `seed` seeds the heads' blur PRNGs (seed .. seed + 7)
+  void Init(float sr, float maxDelay, Sample *buf, uint32_t seed) {
     sampleRate = sr;
     bufferSize = LegacyHelpers::seconds_to_samples(maxDelay, sr);
     buffer = buf;
-    for (int i = 0; i < bufferSize; i++)
-      buffer[i] = 0.0f;
     for (int i = 0; i < 8; i++)
-      readHeads[i].Init(sr, buffer, bufferSize);
+      readHeads[i].Init(sr, buffer, bufferSize, seed + i);
+    // No clearing: nothing is read before the write head has been there
+    SetValidLen(0);
     writeHeadPosition = 0;
 
-    dryAmpSlew.Init();
-    feedbackSlew.Init(0.01f);
-    ampCoefSlew.Init(0.0001f);
+    dryAmpSlew.Init(sr);
+    feedbackSlew.Init(sr, 0.01f);
+    ampCoefSlew.Init(sr, 0.0001f);
     outputLimiter.Init(sr);
     feedbackLimiter.Init(sr);
-    loudness.Init();
+    loudness.Init(sr);
 
     compressor.Init(sr);
     compressor.SetAttack(0.02f);
@@ -201,6 +420,100 @@ public:
     compressor.SetThreshold(0.0f); // 0dB? Original was 0.0.
   }
 
+  // `windows` holds kPrefetchHeadSamples per head
+  void SetPrefetchWindows(Sample *windows) {
+    for (int i = 0; i < 8; i++)
+      for (int s = 0; s < kPrefetchSlots; s++)
+        readHeads[i].win[s] =
+            windows + i * kPrefetchHeadSamples + s * kMaxBlock;
+  }
+
+  // Called after a block of `size` samples: makes what it wrote visible to
+  // the DMA and queues the next block's windows.
+  void QueuePrefetch(MdmaPrefetcher &pf, int size) {
+    int start = LegacyHelpers::wrap_buffer_index(writeHeadPosition - size,
+                                                 bufferSize);
+    int first = std::min(size, bufferSize - start);
+    MdmaPrefetcher::CleanRange(buffer + start, first * sizeof(Sample));
+    if (first < size)
+      MdmaPrefetcher::CleanRange(buffer, (size - first) * sizeof(Sample));
+    for (int i = 0; i < 8; i++)
+      readHeads[i].QueuePrefetch(pf, writeHeadPosition, size);
+  }
+
+  void DropPrefetch() {
+    for (int i = 0; i < 8; i++)
+      readHeads[i].DropPrefetch();
+  }
+
+  void SetValidLen(int n) {
+    validLen = n;
+    for (int i = 0; i < 8; i++)
+      readHeads[i].validLen = n;
+  }
+
+  bool CanProcessBlock(int size) const {
+    for (int i = 0; i < 8; i++)
+      if (!readHeads[i].CanProcessBlock(size))
+        return false;
+    return true;
+  }
+
+  // Same output as calling Process() `size` times (size <= kMaxBlock).
+  // Since no tap reads this block's writes (CanProcessBlock), the heads run
+  // first over the whole block, then the write/feedback loop. in/out
+  // samples are S floats apart.
+  template <size_t S = 1>
+  void ProcessBlock(const float *in, float *out, int size) {
+    float heads[kMaxBlock];
+    float oldAmp[8];
+    int retargetAt[8];
+    for (int j = 0; j < size; j++)
+      heads[j] = 0.0f;
+    for (int i = 0; i < 8; i++) {
+      oldAmp[i] = readHeads[i].ampB;
+      retargetAt[i] =
+          readHeads[i].ProcessBlock(writeHeadPosition, heads, size);
+    }
+    OAM_PROF_MARK(oam::PROF_DELAY_READ);
+
+    // The heads' ampB only change where they retarget, so the feedback
+    // normalisation is only recomputed there.
+    int nextChange = 0;
+    float ampTarget = 0.0f;
+    for (int j = 0; j < size; j++) {
+      if (j == nextChange) {
+        float ampSum = 0.0f;
+        nextChange = size;
+        for (int i = 0; i < 8; i++) {
+          bool taken = retargetAt[i] >= 0 && retargetAt[i] < j;
+          ampSum += taken ? readHeads[i].ampB : oldAmp[i];
+          if (retargetAt[i] >= j && retargetAt[i] + 1 < nextChange)
+            nextChange = retargetAt[i] + 1;
+        }
+        ampTarget = 1.0f / std::max(1.0f, ampSum);
+      }
+      float ampCoef = ampCoefSlew.Process(ampTarget);
+
+      float written = loudness.Process(in[j * S]);
+      float o = compressor.Process(heads[j], written + heads[j]);
+      float fb_val = written + (o * feedbackSlew.Process(feedback) * ampCoef);
+      buffer[writeHeadPosition] = PackSample(-feedbackLimiter.Process(fb_val));
+      heads[j] = o;
+
+      writeHeadPosition =
+          LegacyHelpers::wrap_buffer_index(writeHeadPosition + 1, bufferSize);
+    }
+    if (validLen < bufferSize)
+      SetValidLen(std::min(bufferSize, validLen + size));
+    OAM_PROF_MARK(oam::PROF_FEEDBACK);
+
+    for (int j = 0; j < size; j++)
+      out[j * S] = outputLimiter.Process(heads[j] +
+                                         in[j * S] * dryAmpSlew.Process(dryAmp));
+    OAM_PROF_MARK(oam::PROF_MIX);
+  }
+
   void Set(float d, float f, float b) {
     dryAmp = d;
     feedback = f;
@@ -216,24 +529,29 @@ public:
     }
     ampCoef = ampCoefSlew.Process(1.0f / std::max(1.0f, ampCoef));
 
-    buffer[writeHeadPosition] = loudness.Process(in);
+    float written = loudness.Process(in);
+    buffer[writeHeadPosition] = PackSample(written);
+    if (writeHeadPosition == validLen)
+      SetValidLen(validLen + 1);
 
     for (int i = 0; i < 8; i++)
       out += readHeads[i].Process((float)writeHeadPosition);
+    OAM_PROF_MARK(oam::PROF_DELAY_READ);
 
     // Compressor sidechaining to input?
-    out = compressor.Process(out, buffer[writeHeadPosition] + out);
+    out = compressor.Process(out, written + out);
 
-    float fb_val = buffer[writeHeadPosition] +
-                   (out * feedbackSlew.Process(feedback) * ampCoef);
-    buffer[writeHeadPosition] = -feedbackLimiter.Process(fb_val);
+    float fb_val = written + (out * feedbackSlew.Process(feedback) * ampCoef);
+    buffer[writeHeadPosition] = PackSample(-feedbackLimiter.Process(fb_val));
+
+    OAM_PROF_MARK(oam::PROF_FEEDBACK);
 
     float final_out =
         outputLimiter.Process(out + in * dryAmpSlew.Process(dryAmp));
+    OAM_PROF_MARK(oam::PROF_MIX);
 
-    writeHeadPosition++;
-    if (writeHeadPosition >= bufferSize)
-      writeHeadPosition = 0;
+    writeHeadPosition =
+        LegacyHelpers::wrap_buffer_index(writeHeadPosition + 1, bufferSize);
 
     return final_out;
   }
@@ -243,13 +561,33 @@ class LegacyStereoEngine {
 public:
   LegacyMonoEngine left, right;
   float time_val;
+  float maxDelay; // seconds, what the time knob spans
+  MdmaPrefetcher *prefetch = nullptr;
+
+  // Memory Init() needs for kMaxDelaySeconds per channel at `sr`
+  static constexpr size_t MemoryBytes(float sr) {
+    return 2 * (size_t)(kMaxDelaySeconds * sr) * sizeof(Sample);
+  }
+
+  // Splits `bytes` of memory at `mem` into the two channel buffers, the
+  // delay is capped to kMaxDelaySeconds and shorter if `bytes` is short.
+  void Init(float sr, void *mem, size_t bytes) {
+    size_t per_channel = bytes / 2 / sizeof(Sample);
+    maxDelay = std::min(kMaxDelaySeconds, (float)per_channel / sr);
+    Sample *bufL = static_cast<Sample *>(mem);
+    Sample *bufR = bufL + per_channel;
+    left.Init(sr, maxDelay, bufL, 1);
+    right.Init(sr, maxDelay, bufR, 9);
+  }
 
-  void Init(float sr, float *bufL, float *bufR) {
-    // Hardcoded 150s max?
-    // With 64MB split by 2, we have 32MB per ch. 32MB / 4 bytes = 8M samples.
-    // 8M / 48k = 166 seconds. Fits.
-    left.Init(sr, 150.0f, bufL);
-    right.Init(sr, 150.0f, bufR);
+  // Optional: read the taps from prefetched windows. `windows` holds
+  // kPrefetchWindowSamples and should be in DTCM. Initialise `pf` before
+  // the first block after every Init(): that stops a transfer the last run
+  // left in flight, which would otherwise land in the windows.
+  void EnablePrefetch(MdmaPrefetcher *pf, Sample *windows) {
+    prefetch = pf;
+    left.SetPrefetchWindows(windows);
+    right.SetPrefetchWindows(windows + kPrefetchWindowSamples / 2);
   }
 
   // Call this once per block with control values
@@ -260,7 +598,7 @@ public:
     // Skew -> Distribution
     float distribution = skew_knob;
     float time =
-        time_knob * 150.0f; // Linear mapping simplification for Omnibus
+        time_knob * maxDelay; // Linear mapping simplification for Omnibus
 
     // Feedback map
     float feedback = fb_knob * 3.0f; // 0 to 3
@@ -284,12 +622,39 @@ public:
     }
   }
 
+  // S = 2 reads and writes interleaved L/R frames, inR == inL + 1
+  template <size_t S = 1>
   void ProcessBlock(const float *inL, const float *inR, float *outL,
                     float *outR, size_t size) {
-    for (size_t i = 0; i < size; i++) {
-      outL[i] = left.Process(inL[i]);
-      outR[i] = right.Process(inR[i]);
+    if (prefetch && !prefetch->Wait()) {
+      left.DropPrefetch();
+      right.DropPrefetch();
+    }
+    for (size_t pos = 0; pos < size; pos += kMaxBlock) {
+      int n = (int)std::min(size - pos, (size_t)kMaxBlock);
+      if (left.CanProcessBlock(n) && right.CanProcessBlock(n)) {
+        left.ProcessBlock<S>(inL + pos * S, outL + pos * S, n);
+        right.ProcessBlock<S>(inR + pos * S, outR + pos * S, n);
+      } else {
+        // A tap reads samples written this block, go sample by sample
+        for (int i = 0; i < n; i++) {
+          size_t f = (pos + i) * S;
+          outL[f] = left.Process(inL[f]);
+          outR[f] = right.Process(inR[f]);
+        }
+      }
+    }
+    if (!prefetch)
+      return;
+    if (size > (size_t)kMaxBlock) {
+      left.DropPrefetch();
+      right.DropPrefetch();
+      return;
     }
+    prefetch->Begin();
+    left.QueuePrefetch(*prefetch, (int)size);
+    right.QueuePrefetch(*prefetch, (int)size);
+    prefetch->Kick();
   }
 };
 
@@ -1,8 +1,14 @@
 #include "daisysp.h"
+#include "dsp_profiler.h"
+#include "engine_crossfade.h"
 #include "legacy_engine.h"
 #include "omni_resonator.h"
+#include "param_snapshot.h"
+#include "sdram_arena.h"
 #include "time_machine_hardware.h"
 #include "uber_fdn.h"
+#include <algorithm>
+#include <atomic>
 
 using namespace daisy;
 using namespace daisysp;
@@ -12,13 +18,53 @@ using namespace oam::time_machine;
 TimeMachineHardware hw;
 
 // --- Memory ---
-// 60MB Buffer for Legacy Mode (or Shared use)
-// 150 seconds * 48000 * 2 channels = 14.4M samples = 57.6MB
-#define TOTAL_SDRAM_SAMPLES 15000000
-float DSY_SDRAM_BSS big_sdram_buffer[TOTAL_SDRAM_SAMPLES];
+// All 64MB of SDRAM, handed out by sdram_arena at boot. At 48 kHz:
+//   fdn lines    8 * 2^18 floats, 5.46 s (8.39MB)  studio, shimmer, massive
+//   legacy L+R   2 * 150 s of floats (57.6MB)      legacy (300 s, LEGACY_Q15)
+//   ~1.1MB spare
+// At 96 kHz the FDN lines take twice the memory and the legacy buffers get
+// what is left, about 65 s (131 s with LEGACY_Q15).
+// The regions don't overlap, so two engines can run during a mode
+// crossfade. Never cleared: the delay lines treat memory their write head
+// has not reached yet as silence, so audio can start straight away and an
+// engine can be re-initialised on a mode switch without touching it.
+// That includes boot: libDaisy's SdramHandle::Init() zeroes the
+// .sdram_bss section (DSY_SDRAM_BSS), so the buffer is not declared there
+// but addressed at the FMC bank directly. Keep .sdram_bss empty, anything
+// put in it would overlap the arena and cost the clear again.
+static constexpr size_t kSdramBytes = 64 * 1024 * 1024;
+static constexpr uintptr_t kSdramBase = 0xC0000000; // FMC SDRAM bank 1
+float *const big_sdram_buffer = reinterpret_cast<float *>(kSdramBase);
+oam::SdramArena sdram_arena;
+float *fdn_memory;
+void *legacy_memory;
+size_t legacy_bytes;
 
-// Pointers for FDN (reusing the start of the big buffer)
-DelayLine<float, 240000> delay_lines[8];
+// The layout at both rates, checked here so a bigger engine fails the
+// build: everything fits at 48 kHz, and at 96 kHz the FDN lines fit with
+// a minute of legacy delay left
+static constexpr size_t FdnSdramBytes(float sr) {
+  return oam::ArenaBytes(UberFDN<8>::MemorySamples(sr) * sizeof(float));
+}
+static_assert(FdnSdramBytes(48000.0f) +
+                      oam::ArenaBytes(
+                          oam::legacy::LegacyStereoEngine::MemoryBytes(
+                              48000.0f)) <=
+                  kSdramBytes,
+              "engine delay memory doesn't fit in SDRAM");
+static_assert(FdnSdramBytes(96000.0f) +
+                      2 * (size_t)(60.0f * 96000.0f) *
+                          sizeof(oam::legacy::Sample) <=
+                  kSdramBytes,
+              "96 kHz leaves under a minute of legacy delay");
+
+// Legacy read-head prefetch: MDMA descriptors in non-cached SRAM1, the
+// windows themselves in DTCM
+alignas(8) oam::PrefetchNode DMA_BUFFER_MEM_SECTION
+    legacy_prefetch_nodes[oam::legacy::kPrefetchMaxNodes];
+oam::legacy::Sample DTCM_MEM_SECTION
+    legacy_windows[oam::legacy::kPrefetchWindowSamples];
+oam::MdmaPrefetcher legacy_prefetch;
 
 // --- Engines ---
 UberFDN<8> fdn_engine;
@@ -31,191 +77,567 @@ enum AppMode {
   APP_SHIMMER,
   APP_MASSIVE,
   APP_RESONATOR,
-  APP_LEGACY
+  APP_LEGACY,
+  APP_MODE_LAST
+};
+// Written by the callback when a switch completes
+volatile AppMode current_mode = APP_STUDIO;
+
+// --- Engine switching ---
+// Holding gate 1 high for a second switches to the mode slider 1 points
+// at, with the same ranges as at boot. A different engine is initialised
+// from the main loop while the old one keeps playing, then the callback
+// crossfades. The FDN modes share one engine, so between those the
+// callback fades out, changes the mode at silence and fades back in.
+enum SwitchState {
+  SWITCH_IDLE,
+  SWITCH_CROSSFADE, // current_mode and next_mode both running
+  SWITCH_FADE_OUT,  // FDN mode change, before the mode flips
+  SWITCH_FADE_IN
 };
-AppMode current_mode = APP_STUDIO;
+volatile SwitchState switch_state = SWITCH_IDLE;
+volatile AppMode next_mode = APP_STUDIO;
+oam::EngineCrossfade switch_fade;
+size_t switch_crossfade_len, switch_dip_len; // samples, set in main()
+static constexpr uint32_t kSwitchHoldMs = 1000;
+static constexpr size_t kSwitchChunk = 64;
+
+// Audio buffer layout. By default the callback gets libDaisy's separate
+// L/R buffers; with INTERLEAVED=1 it takes the interleaved L/R frames in
+// DMA order and the engines step through them kFrameStride floats apart.
+#ifdef OAM_INTERLEAVED
+static constexpr size_t kFrameStride = 2;
+#else
+static constexpr size_t kFrameStride = 1;
+#endif
+// Incoming engine's chunk during a crossfade, in the callback's layout
+float switch_buf[2 * kSwitchChunk];
+float *const switch_l = switch_buf;
+float *const switch_r = switch_buf + (kFrameStride == 2 ? 1 : kSwitchChunk);
+
+// Audio block size per mode, in samples. The output lags the input by
+// about two blocks plus the codec, 0.33 ms per block of 16 at 48 kHz.
+// The Resonator is played live and gets the shortest; the engines keep
+// their per-block setup small enough for it. The size is picked once at
+// boot from the selected mode, runtime switches keep it. BLOCK_SIZE=n
+// builds every mode with n.
+#ifdef OAM_BLOCK_SIZE
+// Up to the legacy engine's kMaxBlock, past it the prefetch turns off
+static_assert(OAM_BLOCK_SIZE >= 4 && OAM_BLOCK_SIZE <= oam::legacy::kMaxBlock,
+              "BLOCK_SIZE must be 4..128");
+size_t BlockSizeFor(AppMode) { return OAM_BLOCK_SIZE; }
+#else
+size_t BlockSizeFor(AppMode mode) {
+  switch (mode) {
+  case APP_RESONATOR:
+    return 8;
+  case APP_MASSIVE:
+    return 64; // long tails, latency doesn't matter
+  default:
+    return 32;
+  }
+}
+#endif
+
+// Sample rate: 48 kHz, or 96 kHz when Gate 2 is high at power-up. At 96
+// kHz every mode is timed on a few blocks before audio starts, and only
+// the modes whose worst block stays under kMaxLoad of the block period
+// run there: the boot mode falls back to 48 kHz, runtime switches to a
+// mode that doesn't fit are refused, and so are crossfades whose two
+// engines together pass kMaxCrossfadeLoad.
+static constexpr float kMaxLoad = 0.75f;
+static constexpr float kMaxCrossfadeLoad = 0.95f;
+static constexpr int kProbeBlocks = 24;
+static constexpr int kProbeWarmup = 4; // cold caches, not counted
+float mode_load[APP_MODE_LAST] = {}; // measured at 96 kHz, 0 at 48 kHz
 
 // Controls
-float gains[8];
-float vcas[9] = {1, 1, 1, 1, 1, 1, 1, 1, 1}; // Dummy for legacy
-float sliders_raw[8];
-float dry_mix;
+// Read by the callback every control_blocks blocks, so control timing
+// follows the audio clock: every 32 samples (1.5 kHz) by default, whatever
+// the block size. Blocks longer than that read once per block. Build with
+// CONTROL_DECIMATION=n to read every n * 32 samples; below 1 kHz the
+// knob/CV filters stop smoothing (AnalogControl clamps their coefficient
+// to 1).
+#ifndef OAM_CONTROL_DECIMATION
+#define OAM_CONTROL_DECIMATION 1
+#endif
+static constexpr size_t kControlPeriod = 32 * OAM_CONTROL_DECIMATION;
+static_assert(OAM_CONTROL_DECIMATION >= 1, "CONTROL_DECIMATION must be >= 1");
+size_t control_blocks = 1; // blocks per control read, set in main()
+
+struct ControlFrame {
+  float k_time, k_mod, k_decay; // knob + CV, clamped to 0..1
+  float dry_mix;
+  float sliders[8]; // sliders 1..8, the FDN line gains
+  bool strike;      // gate 2 rose since the last read, Resonator notes
+};
+ControlFrame controls;       // owned by the callback once audio runs
+size_t control_phase = 0;    // blocks since the last control read
+// Copy for the main loop (mode gesture), published after every read
+oam::ParamSnapshot<ControlFrame> ui_controls;
+const float vcas[9] = {1, 1, 1, 1, 1, 1, 1, 1, 1}; // Dummy for legacy
+
+// Set by the first audio callback, for the boot report
+volatile uint32_t first_block_us = 0;
+
+#if defined(OAM_PROFILE) || defined(OAM_BOOT_TRACE)
+// Boot phases recorded in hw.boot, printed once over the USB log
+void PrintBootTimeline() {
+  const oam::BootTimeline &b = hw.boot;
+  hw.PrintLine("boot: mode %d, %u Hz", (int)current_mode,
+               (unsigned)hw.AudioSampleRate());
+  for (int m = 0; m < APP_MODE_LAST; m++)
+    if (mode_load[m] > 0.0f)
+      hw.PrintLine("  mode %d at 96 kHz: %3d%% of a block%s", m,
+                   (int)(mode_load[m] * 100.0f),
+                   mode_load[m] > kMaxLoad ? ", refused" : "");
+  for (int i = 0; i < b.Count(); i++)
+    hw.PrintLine("  %-16s %7u us  (at %7u us)", b.Get(i).name,
+                 (unsigned)b.DurationUs(i), (unsigned)b.Get(i).us);
+  hw.PrintLine("  first audio block at %u us", (unsigned)first_block_us);
+}
+
+// The SDRAM layout, the regions are named after the modes that use them
+void PrintMemoryMap() {
+  hw.PrintLine("sdram: %u of %u bytes used, %u free",
+               (unsigned)sdram_arena.Used(), (unsigned)sdram_arena.Capacity(),
+               (unsigned)sdram_arena.Free());
+  for (int i = 0; i < sdram_arena.RegionCount(); i++) {
+    const oam::SdramArena::Region &r = sdram_arena.GetRegion(i);
+    hw.PrintLine("  %-36s +0x%08x %9u bytes", r.name, (unsigned)r.offset,
+                 (unsigned)r.bytes);
+  }
+}
+#endif
+
+#ifdef OAM_PROFILE
+namespace oam {
+DspProfiler dsp_profiler;
+}
+
+// Dumps the callback load over the USB log, once a second from the main loop
+void PrintProfile() {
+  oam::DspProfiler::Snapshot s = oam::dsp_profiler.GetSnapshot();
+  oam::dsp_profiler.Reset();
+  if (s.blocks == 0)
+    return;
+  unsigned avg = s.total.Avg(s.blocks);
+  hw.PrintLine("mode %d: %u blocks, %u overruns, deadline %u cyc",
+               (int)current_mode, (unsigned)s.blocks, (unsigned)s.overruns,
+               (unsigned)s.deadline);
+  unsigned peak = (unsigned)s.total.max;
+  hw.PrintLine("  %-16s min %6u avg %6u max %6u  (avg %u%%, max %u%%)",
+               "callback", (unsigned)s.total.min, avg, peak,
+               avg * 100 / s.deadline, peak * 100 / s.deadline);
+  for (int i = 0; i < oam::PROF_STAGE_LAST; i++) {
+    const oam::DspProfiler::Stat &st = s.stage[i];
+    if (st.max == 0)
+      continue;
+    hw.PrintLine("  %-16s min %6u avg %6u max %6u", oam::ProfStageName(i),
+                 (unsigned)st.min, (unsigned)st.Avg(s.blocks),
+                 (unsigned)st.max);
+  }
+}
+#endif
 
-// Global Control Vars
-float k_time, k_mod, k_decay;
+bool IsFdnMode(AppMode m) {
+  return m == APP_STUDIO || m == APP_SHIMMER || m == APP_MASSIVE;
+}
+
+FdnMode FdnModeOf(AppMode m) {
+  return m == APP_SHIMMER   ? MODE_SHIMMER
+         : m == APP_MASSIVE ? MODE_MASSIVE
+                            : MODE_STUDIO;
+}
+
+// Slider 1 ranges: 0-20, 20-40, 40-60, 60-80, 80-100
+AppMode ModeFromSelector(float selector) {
+  if (selector < 0.2f)
+    return APP_STUDIO;
+  if (selector < 0.4f)
+    return APP_SHIMMER;
+  if (selector < 0.6f)
+    return APP_MASSIVE;
+  if (selector < 0.8f)
+    return APP_RESONATOR;
+  return APP_LEGACY;
+}
+
+// Reads the knobs, CVs and sliders into one control set. Call
+// hw.ProcessAllControls() first.
+ControlFrame ReadControls() {
+  // --- Read Controls (Knob + CV) ---
+  // Knobs
+  float raw_time_k = hw.GetAdcValue(patch_sm::ADC_10);
+  float raw_skew_k = hw.GetAdcValue(patch_sm::ADC_9);
+  float raw_fb_k = hw.GetAdcValue(patch_sm::CV_8);
+
+  // CVs (Summing)
+  float raw_time_cv = hw.GetAdcValue(patch_sm::CV_2);
+  float raw_skew_cv = hw.GetAdcValue(patch_sm::CV_1);
+  float raw_fb_cv = hw.GetAdcValue(patch_sm::CV_3);
+
+  // Combine & Clamp
+  ControlFrame frame;
+  frame.k_time = raw_time_k + raw_time_cv;
+  if (frame.k_time < 0.0f)
+    frame.k_time = 0.0f;
+  if (frame.k_time > 1.0f)
+    frame.k_time = 1.0f;
+
+  frame.k_mod = raw_skew_k + raw_skew_cv;
+  if (frame.k_mod < 0.0f)
+    frame.k_mod = 0.0f;
+  if (frame.k_mod > 1.0f)
+    frame.k_mod = 1.0f;
+
+  frame.k_decay = raw_fb_k + raw_fb_cv;
+  if (frame.k_decay < 0.0f)
+    frame.k_decay = 0.0f;
+  if (frame.k_decay > 1.0f)
+    frame.k_decay = 1.0f; // Note: Legacy engine might expect >1.0 for self-osc?
+  // Legacy engine multiplies feedback by 3.0 internally in UpdateControls, so
+  // 0..1 input is correct.
+
+  frame.dry_mix = hw.GetSliderValue(0);
+
+  for (int i = 0; i < 8; i++)
+    frame.sliders[i] = hw.GetSliderValue(i + 1);
+  frame.strike = hw.gate_in_2.Trig();
+  return frame;
+}
+
+// Hands a new control set to a mode's engine, from the callback
+void UpdateEngine(AppMode mode, const ControlFrame &c) {
+  if (mode == APP_LEGACY) {
+    legacy_engine.UpdateControls(c.k_time, c.k_mod, c.k_decay, c.dry_mix,
+                                 c.sliders, vcas);
+  } else if (mode == APP_RESONATOR) {
+    if (c.strike)
+      res_engine.Strike();
+  } else {
+    // FDN Modes
+    float safe_decay = c.k_decay;
+    if (mode != APP_MASSIVE) {
+      safe_decay *= 0.98f; // Limit feedback for non-massive modes
+    }
+    fdn_engine.SetDecay(safe_decay);
+  }
+}
+
+// Runs one mode's engine into out_l/out_r. Every engine mixes the dry
+// signal in its own output loop, ramping to c.dry_mix over the block.
+void RenderMode(AppMode mode, const ControlFrame &c, const float *in_l,
+                const float *in_r, float *out_l, float *out_r, size_t size) {
+  if (mode == APP_RESONATOR) {
+    res_engine.ProcessBlock<kFrameStride>(in_l, in_r, out_l, out_r, size,
+                                          c.sliders, c.k_time, c.k_mod,
+                                          c.k_decay, c.dry_mix);
+  } else if (mode == APP_LEGACY) {
+    // Controls arrive block-rate through UpdateEngine(), the legacy engine
+    // slews them itself, dry mix included
+    legacy_engine.ProcessBlock<kFrameStride>(in_l, in_r, out_l, out_r, size);
+  } else {
+    // FDN Modes
+    fdn_engine.ProcessBlock<kFrameStride>(in_l, in_r, out_l, out_r, size,
+                                          c.sliders, 0.2f + (c.k_time * 3.0f),
+                                          0.5f, c.k_mod, c.dry_mix);
+  }
+}
 
+#ifdef OAM_INTERLEAVED
+void AudioCallbackReal(AudioHandle::InterleavingInputBuffer in,
+                       AudioHandle::InterleavingOutputBuffer out,
+                       size_t size) {
+  const float *in_l = in;
+  const float *in_r = in + 1;
+  float *out_l = out;
+  float *out_r = out + 1;
+  size /= 2; // libDaisy counts both channels, the engines count frames
+#else
 void AudioCallbackReal(AudioHandle::InputBuffer in,
                        AudioHandle::OutputBuffer out, size_t size) {
   const float *in_l = in[0];
   const float *in_r = in[1];
   float *out_l = out[0];
   float *out_r = out[1];
+#endif
+  OAM_PROF_BLOCK_BEGIN();
+  if (first_block_us == 0)
+    first_block_us = System::GetUs();
+
+  // Control scheduler: ADCs, mux reads and knob/CV sums at a fixed
+  // fraction of the block rate, handed straight to the running engines
+  AppMode mode = current_mode;
+  const ControlFrame &c = controls;
+  if (++control_phase >= control_blocks) {
+    control_phase = 0;
+    hw.ProcessAllControls();
+    controls = ReadControls();
+    UpdateEngine(mode, c);
+    if (switch_state == SWITCH_CROSSFADE)
+      UpdateEngine(next_mode, c);
+    ui_controls.Back() = c;
+    ui_controls.Publish();
+  }
 
-  if (current_mode == APP_RESONATOR) {
-    res_engine.ProcessBlock(in_l, in_r, out_l, out_r, size, gains, k_time,
-                            k_mod, k_decay);
-    for (size_t i = 0; i < size; i++) {
-      out[0][i] = (out_l[i] * (1.0f - dry_mix)) + (in[0][i] * dry_mix);
-      out[1][i] = (out_r[i] * (1.0f - dry_mix)) + (in[1][i] * dry_mix);
+  RenderMode(mode, c, in_l, in_r, out_l, out_r, size);
+
+  switch (switch_state) {
+  case SWITCH_IDLE:
+    break;
+  case SWITCH_CROSSFADE: {
+    for (size_t pos = 0; pos < size; pos += kSwitchChunk) {
+      size_t n = std::min(size - pos, kSwitchChunk);
+      const size_t f = pos * kFrameStride;
+      RenderMode(next_mode, c, in_l + f, in_r + f, switch_l, switch_r, n);
+      switch_fade.Mix<kFrameStride>(out_l + f, out_r + f, switch_l, switch_r,
+                                    n);
     }
-  } else if (current_mode == APP_LEGACY) {
-    // Update legacy controls block-rate (or frame rate, acceptable)
-    // Note: For best quality we'd do it per sample but legacy impl did it per
-    // blockish We defer control update to main loop, passed via globals? We'll
-    // trust the main loop called UpdateControls.
-    legacy_engine.ProcessBlock(in_l, in_r, out_l, out_r, size);
-    for (size_t i = 0; i < size; i++) {
-      out[0][i] = out_l[i];
-      out[1][i] = out_r[i];
+    if (switch_fade.Done()) {
+      current_mode = next_mode;
+      switch_state = SWITCH_IDLE;
     }
-  } else {
-    // FDN Modes
-    fdn_engine.ProcessBlock(in_l, in_r, out_l, out_r, size, gains,
-                            0.2f + (k_time * 3.0f), 0.5f, k_mod);
-
-    for (size_t i = 0; i < size; i++) {
-      out[0][i] = (out_l[i] * (1.0f - dry_mix)) + (in[0][i] * dry_mix);
-      out[1][i] = (out_r[i] * (1.0f - dry_mix)) + (in[1][i] * dry_mix);
+    break;
+  }
+  case SWITCH_FADE_OUT:
+    switch_fade.FadeOut<kFrameStride>(out_l, out_r, size);
+    if (switch_fade.Done()) {
+      fdn_engine.SetMode(FdnModeOf(next_mode));
+      current_mode = next_mode;
+      UpdateEngine(next_mode, c);
+      switch_fade.Start(switch_dip_len);
+      switch_state = SWITCH_FADE_IN;
     }
+    break;
+  case SWITCH_FADE_IN:
+    switch_fade.FadeIn<kFrameStride>(out_l, out_r, size);
+    if (switch_fade.Done())
+      switch_state = SWITCH_IDLE;
+    break;
   }
+  OAM_PROF_MARK(oam::PROF_MIX);
+  OAM_PROF_BLOCK_END();
 }
 
-int main(void) {
-  hw.Init();
-  hw.SetAudioBlockSize(32); // Slight optimization
-  float samplerate = hw.AudioSampleRate();
+// Carves the SDRAM up once at boot, every mode's engine keeps its region
+// The legacy buffers take what the FDN lines leave, up to kMaxDelaySeconds.
+void AllocateSdram(float samplerate) {
+  sdram_arena.Init(big_sdram_buffer, kSdramBytes);
+  fdn_memory = sdram_arena.Allocate<float>(
+      UberFDN<8>::MemorySamples(samplerate),
+      "fdn lines (studio, shimmer, massive)");
+  legacy_bytes =
+      std::min(oam::legacy::LegacyStereoEngine::MemoryBytes(samplerate),
+               sdram_arena.Free() / oam::kArenaAlign * oam::kArenaAlign);
+  legacy_memory = sdram_arena.Allocate(legacy_bytes, "legacy buffers (legacy)");
+}
 
-  // 1. Initial Control Read for Mode Selection
-  hw.ProcessAllControls();
-  float selector = hw.GetSliderValue(1); // Slider 1
-
-  // Check range - Updated for 5 modes
-  // 0-20, 20-40, 40-60, 60-80, 80-100
-  if (selector < 0.2f) {
-    current_mode = APP_STUDIO;
-    fdn_engine.SetMode(MODE_STUDIO);
-  } else if (selector < 0.4f) {
-    current_mode = APP_SHIMMER;
-    fdn_engine.SetMode(MODE_SHIMMER);
-  } else if (selector < 0.6f) {
-    current_mode = APP_MASSIVE;
-    fdn_engine.SetMode(MODE_MASSIVE);
-  } else if (selector < 0.8f) {
-    current_mode = APP_RESONATOR;
+void InitEngine(AppMode mode, float samplerate) {
+  if (mode == APP_LEGACY) {
+    legacy_engine.Init(samplerate, legacy_memory, legacy_bytes);
+    legacy_prefetch.Init(sizeof(oam::legacy::Sample), legacy_prefetch_nodes,
+                         oam::legacy::kPrefetchMaxNodes);
+    legacy_engine.EnablePrefetch(&legacy_prefetch, legacy_windows);
+  } else if (mode == APP_RESONATOR) {
+    res_engine.Init(samplerate);
   } else {
-    current_mode = APP_LEGACY;
+    fdn_engine.SetMode(FdnModeOf(mode));
+    fdn_engine.Init(samplerate, fdn_memory);
   }
+}
 
-  // Blink LED to confirm Mode
-  int blinks = (int)current_mode + 1;
-  for (int i = 0; i < blinks; i++) {
-    hw.SetLed(true);
-    hw.Delay(150);
-    hw.SetLed(false);
-    hw.Delay(150);
+// Worst block time of `mode` at the current rate, as a fraction of the
+// block period. Runs the engine on noise with every control at its most
+// expensive setting, before audio starts; the engine is left dirty, so
+// InitEngine() it again before it plays.
+float MeasureLoad(AppMode mode, float samplerate, size_t block_size) {
+  static float probe_in[2 * oam::legacy::kMaxBlock];
+  static float probe_out[2 * oam::legacy::kMaxBlock];
+  uint32_t seed = 12345;
+  for (float &s : probe_in) {
+    seed = seed * 1664525u + 1013904223u;
+    s = ((seed >> 9) / 8388608.0f - 1.0f) * 0.5f;
   }
+  // Planar: left then right; interleaved: L/R pairs
+  const size_t right = kFrameStride == 2 ? 1 : block_size;
 
-  // 2. Engine Init
-  if (current_mode == APP_LEGACY) {
-    // Split big buffer into two halves
-    float *bufL = &big_sdram_buffer[0];
-    float *bufR = &big_sdram_buffer[7500000]; // Halfway
-    legacy_engine.Init(samplerate, bufL, bufR);
-  } else if (current_mode == APP_RESONATOR) {
-    res_engine.Init(samplerate);
+  ControlFrame c;
+  c.k_time = c.k_mod = 1.0f; // longest lines, Massive shimmer on
+  c.k_decay = 0.5f;
+  c.dry_mix = 0.5f;
+  for (float &g : c.sliders)
+    g = 1.0f;
+  c.strike = true; // a new Resonator note every block, all of them ringing
+  InitEngine(mode, samplerate);
+
+  oam::EnableCycleCounter();
+  uint32_t worst = 0;
+  for (int b = 0; b < kProbeBlocks; b++) {
+    UpdateEngine(mode, c);
+    uint32_t start = oam::ReadCycleCounter();
+    RenderMode(mode, c, probe_in, probe_in + right, probe_out,
+               probe_out + right, block_size);
+    uint32_t cycles = oam::ReadCycleCounter() - start;
+    if (b >= kProbeWarmup)
+      worst = std::max(worst, cycles);
+  }
+  float period = (float)System::GetSysClkFreq() * block_size / samplerate;
+  return (float)worst / period;
+}
+
+// Whether switching from `from` to `to` fits the CPU at this rate
+bool SwitchFits(AppMode from, AppMode to) {
+  if (mode_load[to] > kMaxLoad)
+    return false;
+  // FDN modes dip instead of crossfading, only one engine runs
+  if (IsFdnMode(from) && IsFdnMode(to))
+    return true;
+  return mode_load[from] + mode_load[to] <= kMaxCrossfadeLoad;
+}
+
+// Starts a switch from the main loop. Returns false if one is running or
+// the new mode doesn't fit at this rate. `c` is the latest control set,
+// the new engine starts from it.
+bool RequestSwitch(AppMode mode, float samplerate, const ControlFrame &c) {
+  if (switch_state != SWITCH_IDLE || mode == current_mode ||
+      !SwitchFits(current_mode, mode))
+    return false;
+  SwitchState state;
+  if (IsFdnMode(mode) && IsFdnMode(current_mode)) {
+    switch_fade.Start(switch_dip_len);
+    state = SWITCH_FADE_OUT;
   } else {
-    // FDN Init - Pass the start of the big buffer
-    fdn_engine.Init(samplerate, &big_sdram_buffer[0]);
+    // The callback doesn't touch this engine until switch_state says so
+    InitEngine(mode, samplerate);
+    UpdateEngine(mode, c);
+    switch_fade.Start(switch_crossfade_len);
+    state = SWITCH_CROSSFADE;
   }
+  next_mode = mode;
+  // Everything above must land before the callback sees the new state
+  std::atomic_signal_fence(std::memory_order_release);
+  switch_state = state;
+  return true;
+}
 
-  // RE-FIXING FDN BUFFER ALLOCATION
-  // We cannot instantiate `DelayLine<float, 240000>` if we also have
-  // `big_sdram_buffer[15000000]`. We need to use `DelayLine<float, 1>` (dummy)
-  // and `SetDelay` with external buffer? DaisySP `DelayLine` implementation: If
-  // we use default constructor with <MaxDelay>, it has `float line_[MaxDelay]`.
-  // We must switch FDN to use Pointers.
-
-  if (current_mode != APP_RESONATOR && current_mode != APP_LEGACY) {
-    // Manual assignments
-    // Requires modification to UberFDN to accept raw pointers or DelayLine
-    // objects initialized with pointers. Let's assume UberFDN Init logic needs
-    // update. Actually, let's cast segments of `big_sdram_buffer` into
-    // something FDN can use. Or just modify UberFDN to take `mid_buffer`? NO
-    // efficiently: Change `delay_lines` to `DelayLine<float, MAX_DELAY>
-    // *delay_lines`? No, standard `DelayLine` class owns its memory. We should
-    // use `DelayLine<float, 1>`? No that limits max delay? DaisySP `DelayLine`
-    // template param `max_delay` defines the array size.
-
-    // OK, Plan B:
-    // The `big_sdram_buffer` IS the memory.
-    // For Legacy: we use it as 2 huge arrays.
-    // For FDN: we cast start of it to 8 distinct arrays.
-    // UberFDN expects `DelayLine<float, 240000>*`.
-    // This is incompatible with raw float pointers.
-    // I will modify `UberFDN` to use `float*` buffers directly + a minimal
-    // Delay helper.
+int main(void) {
+  // Only what the first audio block needs happens before StartAudio, the
+  // rest (QSPI, USB log, mode blink) comes after it.
+  hw.Init(true);
+
+  // 1. Initial Control Read for Mode Selection
+  // The ADC has only just started. Give its DMA a few ms to land real
+  // readings and step the knob/CV filters towards them, so the mode and
+  // the first control set see the actual positions.
+  for (int i = 0; i < 8; i++) {
+    hw.Delay(1);
+    hw.ProcessAllControls();
   }
+  current_mode = ModeFromSelector(hw.GetSliderValue(1)); // Slider 1
+  const size_t block_size = BlockSizeFor(current_mode);
+  hw.SetAudioBlockSize(block_size);
+  hw.boot.Mark("mode select");
+
+  // 2. Sample rate, 96 kHz only if the boot mode keeps up there
+  if (hw.gate_in_2.State()) {
+    hw.SetAudioSampleRate(SaiHandle::Config::SampleRate::SAI_96KHZ);
+    AllocateSdram(hw.AudioSampleRate());
+    for (int m = 0; m < APP_MODE_LAST; m++)
+      mode_load[m] = MeasureLoad((AppMode)m, hw.AudioSampleRate(), block_size);
+    if (mode_load[current_mode] > kMaxLoad) {
+      hw.SetAudioSampleRate(SaiHandle::Config::SampleRate::SAI_48KHZ);
+      std::fill(mode_load, mode_load + APP_MODE_LAST, 0.0f);
+    }
+    hw.boot.Mark("rate check");
+  }
+  float samplerate = hw.AudioSampleRate();
+
+  // 3. Engine Init
+  AllocateSdram(samplerate);
+  InitEngine(current_mode, samplerate);
+  switch_crossfade_len = (size_t)(samplerate * 0.02f);
+  switch_dip_len = (size_t)(samplerate * 0.01f);
+  hw.boot.Mark("engine init");
+
+  // First control set, so the first block has one
+  const size_t control_period =
+      (size_t)((float)kControlPeriod * samplerate / 48000.0f);
+  control_blocks = std::max((size_t)1, control_period / block_size);
+  hw.SetControlDecimation(control_blocks);
+  controls = ReadControls();
+  UpdateEngine(current_mode, controls);
+  ui_controls.Back() = controls;
+  ui_controls.Publish();
+
+#ifdef OAM_PROFILE
+  oam::dsp_profiler.Init(System::GetSysClkFreq(), samplerate,
+                         hw.AudioBlockSize());
+#endif
 
   hw.StartAudio(AudioCallbackReal);
+  hw.boot.Mark("start audio");
+
+  // 4. Non-critical init, audio is already running
+  hw.InitDeferred();
+#if defined(OAM_PROFILE) || defined(OAM_BOOT_TRACE)
+  hw.StartLog(false);
+  hw.boot.Mark("usb log");
+  uint32_t boot_ms = System::GetNow();
+  bool boot_reported = false;
+#endif
+#ifdef OAM_PROFILE
+  uint32_t last_report = System::GetNow();
+#endif
+
+  // Mode confirmation, (mode + 1) blinks from the main loop
+  uint32_t blink_start = System::GetNow();
+  uint32_t blink_ms = ((uint32_t)current_mode + 1) * 300;
+  uint32_t gate_since = 0;
+  bool gate_held = false, gesture_used = false;
 
+  // The controls are read by the callback, this loop only does the
+  // non-realtime work: mode gesture, LED and logging
   while (1) {
-    hw.ProcessAllControls();
+    ui_controls.Acquire();
+    const ControlFrame &frame = ui_controls.Front();
 
-    // --- Read Controls (Knob + CV) ---
-    // Knobs
-    float raw_time_k = hw.GetAdcValue(patch_sm::ADC_10);
-    float raw_skew_k = hw.GetAdcValue(patch_sm::ADC_9);
-    float raw_fb_k = hw.GetAdcValue(patch_sm::CV_8);
-
-    // CVs (Summing)
-    float raw_time_cv = hw.GetAdcValue(patch_sm::CV_2);
-    float raw_skew_cv = hw.GetAdcValue(patch_sm::CV_1);
-    float raw_fb_cv = hw.GetAdcValue(patch_sm::CV_3);
-
-    // Combine & Clamp
-    k_time = raw_time_k + raw_time_cv;
-    if (k_time < 0.0f)
-      k_time = 0.0f;
-    if (k_time > 1.0f)
-      k_time = 1.0f;
-
-    k_mod = raw_skew_k + raw_skew_cv;
-    if (k_mod < 0.0f)
-      k_mod = 0.0f;
-    if (k_mod > 1.0f)
-      k_mod = 1.0f;
-
-    k_decay = raw_fb_k + raw_fb_cv;
-    if (k_decay < 0.0f)
-      k_decay = 0.0f;
-    if (k_decay > 1.0f)
-      k_decay = 1.0f; // Note: Legacy engine might expect >1.0 for self-osc?
-    // Legacy engine multiplies feedback by 3.0 internally in UpdateControls, so
-    // 0..1 input is correct.
-
-    dry_mix = hw.GetSliderValue(0);
-
-    for (int i = 0; i < 8; i++) {
-      sliders_raw[i] = hw.GetSliderValue(i + 1);
-      gains[i] = sliders_raw[i];
-      vcas[i + 1] = 1.0f;
-    }
-    vcas[0] = 1.0f;
-
-    // --- Update Engines ---
-    if (current_mode == APP_LEGACY) {
-      legacy_engine.UpdateControls(k_time, k_mod, k_decay, dry_mix, sliders_raw,
-                                   vcas);
-    } else if (current_mode != APP_RESONATOR) {
-      // FDN Modes
-      float safe_decay = k_decay;
-      if (current_mode != APP_MASSIVE) {
-        safe_decay *= 0.98f; // Limit feedback for non-massive modes
+    // --- Mode switch gesture ---
+    uint32_t now = System::GetNow();
+    if (!hw.gate_in_1.State()) {
+      gate_held = gesture_used = false;
+    } else if (!gate_held) {
+      gate_held = true;
+      gate_since = now;
+    } else if (!gesture_used && now - gate_since >= kSwitchHoldMs) {
+      gesture_used = true;
+      AppMode mode = ModeFromSelector(frame.sliders[0]);
+      if (RequestSwitch(mode, samplerate, frame)) {
+        blink_start = now;
+        blink_ms = ((uint32_t)mode + 1) * 300;
       }
-      fdn_engine.SetDecay(safe_decay);
     }
 
-    hw.SetLed(System::GetNow() & 1024);
+#if defined(OAM_PROFILE) || defined(OAM_BOOT_TRACE)
+    // Give the host a moment to open the port
+    if (!boot_reported && System::GetNow() - boot_ms >= 1000) {
+      boot_reported = true;
+      PrintBootTimeline();
+      PrintMemoryMap();
+    }
+#endif
+#ifdef OAM_PROFILE
+    if (System::GetNow() - last_report >= 1000) {
+      last_report = System::GetNow();
+      PrintProfile();
+    }
+#endif
+
+    uint32_t since_blink = System::GetNow() - blink_start;
+    if (since_blink < blink_ms)
+      hw.SetLed(since_blink % 300 < 150);
+    else
+      hw.SetLed(System::GetNow() & 1024);
     hw.Delay(4);
   }
 }
@@ -0,0 +1,162 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#if defined(STM32H750xx)
+#include "stm32h7xx_hal.h"
+#endif
+
+/**
+ * Background copies from SDRAM into tightly coupled memory.
+ *
+ * The engine queues a list of (dst, src, bytes) copies, kicks them off at the
+ * end of a callback and checks them at the start of the next one. On the
+ * STM32H750 the list runs as one MDMA linked-list transfer triggered by a
+ * single software request, so the CPU is free while it runs. On the host the
+ * copies happen immediately in Queue().
+ *
+ * Requirements on target:
+ *  - nodes live in non-cacheable memory the MDMA can read
+ *    (DMA_BUFFER_MEM_SECTION), 8-byte aligned.
+ *  - destinations are in DTCM (the channel's destination bus is set to TCM).
+ *  - the source range must be clean in the D-cache; CleanRange() does that
+ *    for data the CPU has just written.
+ */
+
+namespace oam {
+
+#if defined(STM32H750xx)
+typedef MDMA_LinkNodeTypeDef PrefetchNode;
+#else
+struct PrefetchNode {
+  uint32_t unused;
+};
+#endif
+
+class MdmaPrefetcher {
+public:
+  /** elem_size is the sample size in bytes (2 or 4) */
+  void Init(size_t elem_size, PrefetchNode *nodes, size_t max_nodes) {
+    nodes_ = nodes;
+    max_nodes_ = max_nodes;
+    count_ = 0;
+    busy_ = false;
+#if defined(STM32H750xx)
+    __HAL_RCC_MDMA_CLK_ENABLE();
+    uint32_t size_bits =
+        elem_size == 2 ? (MDMA_CTCR_SSIZE_0 | MDMA_CTCR_DSIZE_0 |
+                          MDMA_CTCR_SINCOS_0 | MDMA_CTCR_DINCOS_0)
+                       : (MDMA_CTCR_SSIZE_1 | MDMA_CTCR_DSIZE_1 |
+                          MDMA_CTCR_SINCOS_1 | MDMA_CTCR_DINCOS_1);
+    // Incrementing src/dst, 128 byte buffer transfers, the whole linked
+    // list on one software request.
+    ctcr_ = MDMA_CTCR_SINC_1 | MDMA_CTCR_DINC_1 | size_bits |
+            (127u << MDMA_CTCR_TLEN_Pos) | MDMA_CTCR_TRGM | MDMA_CTCR_SWRM;
+    kChannel->CCR = 0;
+    // Anything the CPU wrote to SDRAM before audio started
+    SCB_CleanDCache();
+#else
+    (void)elem_size;
+#endif
+  }
+
+  /** Starts a new list, call before the first Queue() of a block */
+  void Begin() { count_ = 0; }
+
+  /** Adds one copy. Returns false when the node list is full. */
+  bool Queue(void *dst, const void *src, size_t bytes) {
+    if (count_ >= max_nodes_ || bytes == 0)
+      return false;
+#if defined(STM32H750xx)
+    PrefetchNode &n = nodes_[count_];
+    n.CTCR = ctcr_;
+    n.CBNDTR = (uint32_t)bytes & MDMA_CBNDTR_BNDT;
+    n.CSAR = (uint32_t)src;
+    n.CDAR = (uint32_t)dst;
+    n.CBRUR = 0;
+    n.CLAR = 0;
+    n.CTBR = MDMA_CTBR_DBUS; // destination on the AHB/TCM bus
+    n.CMAR = 0;
+    n.CMDR = 0;
+    if (count_ > 0)
+      nodes_[count_ - 1].CLAR = (uint32_t)&n;
+#else
+    memcpy(dst, src, bytes);
+#endif
+    count_++;
+    return true;
+  }
+
+  /** Starts the queued copies */
+  void Kick() {
+    if (count_ == 0)
+      return;
+#if defined(STM32H750xx)
+    const PrefetchNode &n = nodes_[0];
+    kChannel->CCR = 0;
+    kChannel->CIFCR = MDMA_CIFCR_CTEIF | MDMA_CIFCR_CCTCIF | MDMA_CIFCR_CBRTIF |
+                      MDMA_CIFCR_CBTIF | MDMA_CIFCR_CLTCIF;
+    kChannel->CTCR = n.CTCR;
+    kChannel->CBNDTR = n.CBNDTR;
+    kChannel->CSAR = n.CSAR;
+    kChannel->CDAR = n.CDAR;
+    kChannel->CBRUR = 0;
+    kChannel->CLAR = n.CLAR;
+    kChannel->CTBR = n.CTBR;
+    kChannel->CMAR = 0;
+    kChannel->CMDR = 0;
+    kChannel->CCR = MDMA_CCR_EN;
+    kChannel->CCR |= MDMA_CCR_SWRQ;
+#endif
+    busy_ = true;
+  }
+
+  /**
+   * Checks that the last Kick() has finished. It was kicked a whole block
+   * earlier, so there is no waiting: one poll, and if the transfer failed
+   * or is still running the channel is stopped and this returns false, in
+   * which case the destinations must not be used and the caller reads
+   * SDRAM directly. Spinning here would run in the audio interrupt, every
+   * block for as long as the fault lasts. Returns true straight away if
+   * nothing is in flight.
+   */
+  bool Wait() {
+    if (!busy_)
+      return true;
+    busy_ = false;
+#if defined(STM32H750xx)
+    uint32_t isr = kChannel->CISR;
+    if ((isr & MDMA_CISR_CTCIF) && !(isr & MDMA_CISR_TEIF))
+      return true;
+    kChannel->CCR = 0;
+    return false;
+#else
+    return true;
+#endif
+  }
+
+  /** Writes back data the CPU wrote to [addr, addr + bytes) */
+  static void CleanRange(const void *addr, size_t bytes) {
+#if defined(STM32H750xx)
+    uintptr_t start = (uintptr_t)addr & ~(uintptr_t)31;
+    uintptr_t end = (uintptr_t)addr + bytes;
+    SCB_CleanDCache_by_Addr((uint32_t *)start, (int32_t)(end - start));
+#else
+    (void)addr;
+    (void)bytes;
+#endif
+  }
+
+private:
+#if defined(STM32H750xx)
+  MDMA_Channel_TypeDef *const kChannel = MDMA_Channel0;
+  uint32_t ctcr_;
+#endif
+  PrefetchNode *nodes_;
+  size_t max_nodes_;
+  size_t count_;
+  bool busy_;
+};
+
+} // namespace oam
@@ -1,94 +1,321 @@
 #pragma once
 #include "daisysp.h"
+#include "dry_wet.h"
+#include "dsp_profiler.h"
+#include "fast_math.h"
 #include <cmath>
 
 using namespace daisysp;
 
-class OmniResonatorVoice {
+// One note's partials as a bank of two-pole resonators,
+//   y = b0 x + a1 y[-1] - a2 y[-2],
+// with every field in its own array so the per-sample loop is one pass
+// over plain multiply-adds. The poles only move in SetModes(), the input
+// gains in SetGains(); both run once per block at most.
+template <int N> class OmniModalBank {
 public:
-  void Init(float sr) {
-    sr_ = sr;
-    svf_.Init(sr);
-    freq_ = 440.0f;
-    res_ = 0.5f;
+  static constexpr float kFloor = 1e-14f; // squared amplitude, -140 dB
+
+  void Init() {
+    for (int k = 0; k < N; k++) {
+      b0_[k] = a1_[k] = a2_[k] = 0.0f;
+      y1_[k] = y2_[k] = 0.0f;
+      norm_[k] = 0.0f;
+      cos_w_[k] = 1.0f;
+      inv_sin2_w_[k] = 0.0f;
+    }
+    modes_ = 0;
+    level_ = 0.0f;
+  }
+
+  // Tunes the first `count` modes to freqs[] (Hz), each ringing with
+  // quality q, so higher partials die faster as on a struck object. The
+  // input is scaled for a resonance gain of `peak`. Modes from `count` on
+  // are dropped.
+  void SetModes(const float *freqs, int count, float q, float peak,
+                float sample_rate) {
+    const float w_scale = 2.0f * 3.1415927f / sample_rate;
+    for (int k = 0; k < count; k++) {
+      float w = freqs[k] * w_scale;
+      float s = oam::FastSin(w);
+      // cos w from the half angle, which keeps the low notes in tune
+      float h = oam::FastSin(0.5f * w);
+      float c = 1.0f - 2.0f * h * h;
+      float r = oam::FastExp(-w / (2.0f * q));
+      a1_[k] = 2.0f * r * c;
+      a2_[k] = r * r;
+      // |H| at the resonance is about b0 / (2 (1 - r) sin w)
+      norm_[k] = peak * 2.0f * (1.0f - r) * s;
+      cos_w_[k] = c;
+      inv_sin2_w_[k] = 1.0f / (s * s);
+    }
+    for (int k = count; k < modes_; k++)
+      y1_[k] = y2_[k] = 0.0f;
+    modes_ = count;
+  }
+
+  // Input gain per mode, on top of the normalisation
+  void SetGains(const float *gains) {
+    for (int k = 0; k < modes_; k++)
+      b0_[k] = norm_[k] * gains[k];
+  }
+  void Mute() {
+    for (int k = 0; k < modes_; k++)
+      b0_[k] = 0.0f;
   }
 
-  float Process(float in) {
-    svf_.SetFreq(freq_);
-    svf_.SetRes(res_);
-    svf_.Process(in);
-    return svf_.Band();
+  // Adds the modes' output for input x, panned, to l and r
+  void Process(float x, const float *pan_l, const float *pan_r, float &l,
+               float &r) {
+    for (int k = 0; k < modes_; k++) {
+      float y = b0_[k] * x + a1_[k] * y1_[k] - a2_[k] * y2_[k];
+      y2_[k] = y1_[k];
+      y1_[k] = y;
+      l += y * pan_l[k];
+      r += y * pan_r[k];
+    }
+  }
+
+  // Squared amplitude of the loudest mode, from its last two outputs.
+  // Call after a block; a bank that didn't run keeps its level.
+  float Level() const { return level_; }
+  void EndBlock() {
+    float level = 0.0f;
+    for (int k = 0; k < modes_; k++) {
+      float y1 = y1_[k], y2 = y2_[k];
+      float a2 = (y1 * y1 + y2 * y2 - 2.0f * y1 * y2 * cos_w_[k]) *
+                 inv_sin2_w_[k];
+      // The high modes die long before the note; stop them before they
+      // decay into denormals
+      if (a2 < kFloor)
+        y1_[k] = y2_[k] = 0.0f;
+      level = fmaxf(level, a2);
+    }
+    level_ = level;
   }
-  void SetFreq(float f) { freq_ = f; }
-  void SetRes(float r) { res_ = r; }
 
 private:
-  float sr_, freq_, res_;
-  Svf svf_;
+  float b0_[N], a1_[N], a2_[N];
+  float y1_[N], y2_[N];
+  float norm_[N];                  // b0 for a gain of 1
+  float cos_w_[N], inv_sin2_w_[N]; // for Level()
+  int modes_;                      // modes below the frequency limit
+  float level_;
 };
 
+// Starts mono: one note, tuned by the note CV and excited by the input.
+// The first Strike() turns on polyphony: every strike, and every note
+// change after it, starts a new note on a free slot (or the quietest) at
+// the current pitch. Only the newest note is excited, the older ones ring
+// out at their pitch. A note with no input whose level has decayed under
+// kSilence is skipped, so long releases and pulled-down sliders cost
+// nothing. Polyphony stays on until the next Init(): switching modes away
+// and back, or a reboot, returns to mono.
+//
+// Each note is kPartials modes. The eight sliders are a spectral envelope
+// over them, on a log scale: slider 1 is the fundamental, slider 8 the
+// top partial. Partials alternate between leaning left and right.
 class OmniResonatorEngine {
 public:
+  static constexpr int kPartials = 32;
+  static constexpr int kNotes = 4;
+  static constexpr float kSilence = 1e-8f;    // squared amplitude, -80 dB
+  static constexpr float kStrike = 1.0f;      // impulse into a struck note
+  static constexpr float kMaxModeHz = 16000.0f;
+  static constexpr float kPeakGain = 7.0f;    // mode gain at resonance
+  static constexpr float kNoteHysteresis = 0.6f; // semitones
+
   void Init(float sample_rate) {
     sr_ = sample_rate;
-    for (int i = 0; i < 8; i++) {
-      voices_l_[i].Init(sr_);
-      voices_r_[i].Init(sr_);
+    // The exciter is a first difference, which falls with the rate for the
+    // same input; the boost keeps its level at 48 kHz
+    exciter_gain_ = 4.0f * sample_rate / 48000.0f;
+    exciter_prev_ = 0.0f;
+    max_mode_hz_ = fminf(kMaxModeHz, 0.45f * sample_rate);
+    dry_wet_.Reset();
+    for (int n = 0; n < kNotes; n++) {
+      notes_[n].Init();
+      note_freq_[n] = 110.0f;
+      tuned_freq_[n] = -1.0f;
+      tuned_gen_[n] = 0;
     }
     root_freq_ = 110.0f;
+    midi_note_ = -100.0f; // far from any note CV
+    structure_ = -1.0f;
+    damping_ = -1.0f;
+    tuning_gen_ = 0;
+    poly_ = false;
+    strike_ = false;
+    note_ = 0;
+    for (int k = 0; k < kPartials; k++) {
+      inharm_[k] = 1.0f + (k * 1.5f) + (oam::FastSin(k * 34.0f) * 0.5f);
+      // The fundamental in the middle, the rest alternating sides
+      pan_l_[k] = k > 0 && (k & 1) ? 0.5f : 1.0f;
+      pan_r_[k] = k > 0 && !(k & 1) ? 0.5f : 1.0f;
+      // Slider envelope position and a gentle roll-off
+      slider_pos_[k] = oam::FastLog2((float)(k + 1)) *
+                       (7.0f / oam::FastLog2((float)kPartials));
+      rolloff_[k] = 1.0f / (1.0f + 0.25f * (float)k);
+    }
   }
 
+  // A gate: the next block starts a new note, see above
+  void Strike() { strike_ = true; }
+
+  // Writes the final dry/wet mix, dry_mix ramps over the block. Frames are
+  // S floats apart, S = 2 runs on interleaved L/R buffers.
+  template <size_t S = 1>
   void ProcessBlock(const float *in_l, const float *in_r, float *out_l,
                     float *out_r, size_t size, const float *harmonic_gains,
-                    float note_cv, float structure, float damping) {
-    float midi_note = 36.0f + (note_cv * 60.0f);
-    midi_note = floorf(midi_note + 0.5f);
-    root_freq_ = mtof(midi_note);
-    UpdateRatios(structure);
+                    float note_cv, float structure, float damping,
+                    float dry_mix) {
+    // Tuning is a block constant, and only recomputed when the note, the
+    // structure or the damping moves, so short blocks stay cheap.
+    // The note only moves once the CV is kNoteHysteresis past the current
+    // one, so a knob or CV resting on a semitone boundary doesn't flicker
+    // between two notes (and, in poly, steal a slot on every flip)
+    float raw_note = 36.0f + (note_cv * 60.0f);
+    const bool note_moved = fabsf(raw_note - midi_note_) > kNoteHysteresis;
+    const bool new_note = strike_ || (poly_ && note_moved);
+    if (note_moved) {
+      float midi_note = floorf(raw_note + 0.5f);
+      midi_note_ = midi_note;
+      root_freq_ =
+          440.0f * oam::FastExp2((midi_note - 69.0f) * (1.0f / 12.0f));
+    }
+    if (structure != structure_) {
+      structure_ = structure;
+      UpdateRatios(structure);
+      tuning_gen_++;
+    }
+    if (damping != damping_) {
+      damping_ = damping;
+      // Same quality as the Svf voices this replaced, resonance 0.8..0.9995
+      float t_damp = damping * damping;
+      float res = 0.80f + (t_damp * 0.1995f);
+      q_ = 0.5f / (1.0f - oam::FastPow(res, 0.25f));
+      tuning_gen_++;
+    }
+    float strike = strike_ ? kStrike : 0.0f; // first sample only
+    if (new_note) {
+      poly_ = poly_ || strike_;
+      note_ = QuietestNote();
+    }
+    strike_ = false;
+    note_freq_[note_] = root_freq_;
+
+    // Input gains of the excited note, the sliders interpolated
+    float gains[kPartials];
+    bool excited = false;
+    for (int k = 0; k < kPartials; k++) {
+      float pos = slider_pos_[k];
+      int s = (int)pos;
+      if (s > 6)
+        s = 6;
+      float g = harmonic_gains[s] +
+                (pos - (float)s) * (harmonic_gains[s + 1] - harmonic_gains[s]);
+      gains[k] = g * rolloff_[k];
+      excited = excited || gains[k] > 0.0f;
+    }
 
-    float t_damp = damping * damping;
-    float res_val = 0.80f + (t_damp * 0.1995f);
+    // The notes that run this block. Poles only move on these: a skipped
+    // note keeps its old tuning, and the generation check retunes it when
+    // it comes back.
+    int active[kNotes];
+    int active_count = 0;
+    for (int n = 0; n < kNotes; n++) {
+      OmniModalBank<kPartials> &bank = notes_[n];
+      const bool input = n == note_ && excited;
+      if (!input && bank.Level() < kSilence)
+        continue;
+      if (tuned_gen_[n] != tuning_gen_ || note_freq_[n] != tuned_freq_[n])
+        Tune(n);
+      if (input)
+        bank.SetGains(gains);
+      else
+        bank.Mute();
+      active[active_count++] = n;
+    }
+    dry_wet_.Begin(dry_mix, size);
 
     for (size_t i = 0; i < size; i++) {
-      float input = (in_l[i] + in_r[i]) * 0.5f;
-      static float prev = 0.0f;
-      float exciter = input - prev;
-      prev = input;
-      exciter = exciter * 4.0f; // Boost
+      float input = (in_l[i * S] + in_r[i * S]) * 0.5f;
+      float exciter = (input - exciter_prev_) * exciter_gain_ + strike; // Boost
+      exciter_prev_ = input;
+      strike = 0.0f;
 
       float sum_l = 0.0f, sum_r = 0.0f;
-
-      for (int k = 0; k < 8; k++) {
-        float f = root_freq_ * ratios_[k];
-        if (f > 16000.0f)
-          f = 16000.0f;
-        float detune = 1.0f + (0.01f * (k % 2 == 0 ? 1 : -1));
-
-        voices_l_[k].SetFreq(f);
-        voices_r_[k].SetFreq(f * detune);
-        voices_l_[k].SetRes(res_val);
-        voices_r_[k].SetRes(res_val);
-
-        sum_l += voices_l_[k].Process(exciter * harmonic_gains[k]);
-        sum_r += voices_r_[k].Process(exciter * harmonic_gains[k]);
-      }
-      out_l[i] = sum_l * 0.8f;
-      out_r[i] = sum_r * 0.8f;
+      for (int a = 0; a < active_count; a++)
+        notes_[active[a]].Process(exciter, pan_l_, pan_r_, sum_l, sum_r);
+      OAM_PROF_MARK(oam::PROF_FEEDBACK);
+      float dry = dry_wet_.Next();
+      out_l[i * S] = (sum_l * 0.8f) * (1.0f - dry) + in_l[i * S] * dry;
+      out_r[i * S] = (sum_r * 0.8f) * (1.0f - dry) + in_r[i * S] * dry;
+      OAM_PROF_MARK(oam::PROF_MIX);
     }
+    for (int a = 0; a < active_count; a++)
+      notes_[active[a]].EndBlock();
   }
 
 private:
   float sr_;
-  OmniResonatorVoice voices_l_[8];
-  OmniResonatorVoice voices_r_[8];
+  float exciter_gain_;
+  float exciter_prev_;
+  float max_mode_hz_; // partials above are dropped
+  oam::DryWetRamp dry_wet_;
+  OmniModalBank<kPartials> notes_[kNotes];
+  float note_freq_[kNotes];
+  float tuned_freq_[kNotes]; // note_freq_ the bank was tuned for
+  uint32_t tuned_gen_[kNotes]; // tuning_gen_ the bank was tuned with
+  uint32_t tuning_gen_;        // bumped when ratios_ or q_ change
   float root_freq_;
-  float ratios_[8];
+  float midi_note_; // note root_freq_ is tuned to
+  float structure_; // structure ratios_ were computed for
+  float damping_;   // damping q_ was computed for
+  float q_;
+  float ratios_[kPartials];
+  float inharm_[kPartials];
+  float pan_l_[kPartials], pan_r_[kPartials];
+  float slider_pos_[kPartials]; // 0..7, slider envelope position
+  float rolloff_[kPartials];
+  bool poly_;   // a strike has come since Init()
+  bool strike_; // Strike() since the last block
+  int note_;    // the slot the input excites
+
+  void Tune(int n) {
+    float freqs[kPartials];
+    int count = 0;
+    // The ratios rise with k, the first one over the limit ends the note
+    while (count < kPartials &&
+           (freqs[count] = note_freq_[n] * ratios_[count]) < max_mode_hz_)
+      count++;
+    notes_[n].SetModes(freqs, count, q_, kPeakGain, sr_);
+    tuned_freq_[n] = note_freq_[n];
+    tuned_gen_[n] = tuning_gen_;
+  }
+
+  // The slot for a new note: the quietest other than the current one.
+  // Stealing a ringing note retunes it, so prefer the one that has faded.
+  int QuietestNote() const {
+    int best = note_;
+    float best_level = 0.0f;
+    for (int n = 0; n < kNotes; n++) {
+      if (n == note_)
+        continue;
+      float level = notes_[n].Level();
+      if (best == note_ || level < best_level) {
+        best = n;
+        best_level = level;
+      }
+    }
+    return best;
+  }
 
   void UpdateRatios(float structure) {
-    for (int i = 0; i < 8; i++) {
+    for (int i = 0; i < kPartials; i++) {
       float h = (float)(i + 1);
       float odd = 1.0f + (i * 2.0f);
-      float inharm = 1.0f + (i * 1.5f) + (sinf(i * 34.0f) * 0.5f);
+      float inharm = inharm_[i];
 
       if (structure < 0.5f) {
         float t = structure * 2.0f;
@@ -0,0 +1,49 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+
+/**
+ * Lock-free hand-over of parameter sets from the control loop to the audio
+ * callback, as a triple buffer.
+ *
+ * The writer fills Back() completely and calls Publish(). The reader calls
+ * Acquire() once per block and then reads Front(), which stays put until
+ * its next Acquire(). Neither side waits or masks interrupts, and the
+ * reader only ever sees whole sets, the newest one published. One writer
+ * and one reader, either may preempt the other.
+ */
+
+namespace oam {
+
+template <typename T> class ParamSnapshot {
+public:
+  /** Writer side, the slot to fill. Holds stale data, set every field. */
+  T &Back() { return slots_[back_]; }
+
+  void Publish() {
+    uint32_t prev = middle_.exchange(back_ | kFresh, std::memory_order_acq_rel);
+    back_ = prev & kIndexMask;
+  }
+
+  /** Reader side. Returns true if a newer set became Front(). */
+  bool Acquire() {
+    if (!(middle_.load(std::memory_order_relaxed) & kFresh))
+      return false;
+    uint32_t prev = middle_.exchange(front_, std::memory_order_acq_rel);
+    front_ = prev & kIndexMask;
+    return true;
+  }
+
+  const T &Front() const { return slots_[front_]; }
+
+private:
+  static const uint32_t kIndexMask = 3;
+  static const uint32_t kFresh = 4; // middle slot not read yet
+
+  T slots_[3] = {};
+  uint32_t back_ = 0;  // writer only
+  uint32_t front_ = 1; // reader only
+  std::atomic<uint32_t> middle_{2};
+};
+
+} // namespace oam
@@ -0,0 +1,88 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * Power-of-two ring buffer for the delay, allpass and diffuser lines.
+ *
+ * The write position is a free-running 32-bit sample counter and every
+ * index is that counter masked, so no index needs a compare or a loop to
+ * wrap. Delays count back from the write position: 1 is the newest sample.
+ *
+ * Fractional reads use a fixed-point phase with 32 - log2(size) fraction
+ * bits, so one turn of the ring is exactly 2^32 and the read position
+ * wraps with the integer arithmetic itself.
+ *
+ * The memory is not cleared: anything the write position has not reached
+ * since Init() reads as silence. Clear() zeroes it instead, for small
+ * buffers that are cheap to clear.
+ */
+
+namespace oam {
+
+/** Smallest power of two >= n */
+constexpr size_t RingSize(size_t n) {
+  size_t size = 1;
+  while (size < n)
+    size <<= 1;
+  return size;
+}
+
+template <typename T> class RingBuffer {
+public:
+  /** `size` must be a power of two of at least 2, see RingSize() */
+  void Init(T *buf, size_t size) {
+    buf_ = buf;
+    mask_ = (uint32_t)size - 1;
+    write_ = 0;
+    valid_ = 0;
+    int bits = 0;
+    while ((size_t)1 << bits < size)
+      bits++;
+    frac_bits_ = 32 - bits;
+    frac_mask_ = (1u << frac_bits_) - 1u;
+    frac_scale_ = (float)(1u << frac_bits_);
+    inv_frac_scale_ = 1.0f / frac_scale_;
+  }
+
+  void Clear() {
+    for (uint32_t i = 0; i <= mask_; i++)
+      buf_[i] = T(0);
+    valid_ = mask_ + 1;
+  }
+
+  uint32_t Size() const { return mask_ + 1; }
+
+  void Write(T sample) {
+    buf_[write_ & mask_] = sample;
+    write_++;
+    valid_ += valid_ <= mask_;
+  }
+
+  /** The sample written `delay` writes ago, delay in [1, Size()] */
+  T Tap(uint32_t delay) const { return At((write_ - delay) & mask_); }
+
+  /** Linear interpolation `delay` samples back, delay in [1, Size() - 1) */
+  float Read(float delay) const {
+    uint32_t pos = (write_ << frac_bits_) - (uint32_t)(delay * frac_scale_);
+    uint32_t i = pos >> frac_bits_;
+    float frac = (float)(pos & frac_mask_) * inv_frac_scale_;
+    float a = At(i);
+    float b = At((i + 1) & mask_);
+    return a + frac * (b - a);
+  }
+
+private:
+  T At(uint32_t i) const { return i < valid_ ? buf_[i] : T(0); }
+
+  T *buf_;
+  uint32_t mask_;
+  uint32_t write_; // samples written since Init()
+  uint32_t valid_; // buf_[0, valid_) has been written or cleared
+  int frac_bits_;
+  uint32_t frac_mask_;
+  float frac_scale_; // 2^frac_bits_
+  float inv_frac_scale_;
+};
+
+} // namespace oam
@@ -0,0 +1,79 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * Bump allocator over the SDRAM buffer.
+ *
+ * Engines take their delay memory from it once, at boot; blocks are never
+ * freed one by one. Every block is cache-line aligned and recorded under a
+ * name, so main() can print the memory map. Allocate() returns nullptr when
+ * the arena is full; main.cpp also checks the fixed layout at compile time
+ * with ArenaBytes().
+ *
+ * Nothing is cleared: the engines treat memory they have not written since
+ * Init() as silence.
+ */
+
+namespace oam {
+
+static constexpr size_t kArenaAlign = 32; // Cortex-M7 D-cache line
+
+/** Bytes a block of `bytes` takes in the arena, padding included */
+constexpr size_t ArenaBytes(size_t bytes) {
+  return (bytes + kArenaAlign - 1) / kArenaAlign * kArenaAlign;
+}
+
+class SdramArena {
+public:
+  static const int kMaxRegions = 8;
+
+  struct Region {
+    const char *name; // string literal
+    size_t offset;
+    size_t bytes;
+  };
+
+  void Init(void *mem, size_t bytes) {
+    // Start on an aligned address, the end is whatever is left
+    uintptr_t base = (uintptr_t)mem;
+    uintptr_t start = (base + kArenaAlign - 1) & ~(uintptr_t)(kArenaAlign - 1);
+    base_ = (uint8_t *)start;
+    capacity_ = bytes > start - base ? bytes - (start - base) : 0;
+    used_ = 0;
+    count_ = 0;
+  }
+
+  void *Allocate(size_t bytes, const char *name) {
+    size_t padded = ArenaBytes(bytes);
+    if (padded > capacity_ - used_ || count_ >= kMaxRegions)
+      return nullptr;
+    regions_[count_].name = name;
+    regions_[count_].offset = used_;
+    regions_[count_].bytes = bytes;
+    count_++;
+    void *p = base_ + used_;
+    used_ += padded;
+    return p;
+  }
+
+  template <typename T> T *Allocate(size_t count, const char *name) {
+    return static_cast<T *>(Allocate(count * sizeof(T), name));
+  }
+
+  size_t Capacity() const { return capacity_; }
+  size_t Used() const { return used_; }
+  size_t Free() const { return capacity_ - used_; }
+
+  int RegionCount() const { return count_; }
+  const Region &GetRegion(int i) const { return regions_[i]; }
+
+private:
+  uint8_t *base_ = nullptr;
+  size_t capacity_ = 0;
+  size_t used_ = 0;
+  Region regions_[kMaxRegions];
+  int count_ = 0;
+};
+
+} // namespace oam
@@ -221,7 +221,7 @@ namespace time_machine
  *  move the rest of the implementation to the Impl class
  */
 
-    void TimeMachineHardware::Init()
+    void TimeMachineHardware::Init(bool defer)
     {
         /** Assign pimpl pointer */
         pimpl_ = &patch_sm_hw;
@@ -234,26 +234,14 @@ namespace time_machine
             syscfg.skip_clocks = true;
 
         system.Init(syscfg);
+        boot.Mark("clocks");
         /** Memories */
         if(memory == System::MemoryRegion::INTERNAL_FLASH)
         {
             /** FMC SDRAM */
             sdram.Init();
         }
-        if(memory != System::MemoryRegion::QSPI)
-        {
-            /** QUADSPI FLASH */
-            QSPIHandle::Config qspi_config;
-            qspi_config.device = QSPIHandle::Config::Device::IS25LP064A;
-            qspi_config.mode   = QSPIHandle::Config::Mode::MEMORY_MAPPED;
-            qspi_config.pin_config.io0 = {DSY_GPIOF, 8};
-            qspi_config.pin_config.io1 = {DSY_GPIOF, 9};
-            qspi_config.pin_config.io2 = {DSY_GPIOF, 7};
-            qspi_config.pin_config.io3 = {DSY_GPIOF, 6};
-            qspi_config.pin_config.clk = {DSY_GPIOF, 10};
-            qspi_config.pin_config.ncs = {DSY_GPIOG, 6};
-            qspi.Init(qspi_config);
-        }
+        boot.Mark("sdram");
         /** Audio */
         // Audio Init
         SaiHandle::Config sai_config;
@@ -281,6 +269,7 @@ namespace time_machine
         I2CHandle i2c2;
         i2c2.Init(i2c_cfg);
         codec.Init(i2c2);
+        boot.Mark("sai/codec");
 
         /*
         dsy_gpio scl;
@@ -302,6 +291,7 @@ namespace time_machine
         audio_config.postgain   = 1.f;
         audio.Init(audio_config, sai_1_handle);
         callback_rate_ = AudioSampleRate() / AudioBlockSize();
+        boot.Mark("audio");
 
         /** ADC Init */
         AdcChannelConfig adc_config[ADC_LAST + 7];
@@ -395,9 +385,12 @@ namespace time_machine
         user_led.pull = DSY_GPIO_NOPULL;
         user_led.pin  = PIN_USER_LED;
         dsy_gpio_init(&user_led);
+
+        // Gate 2 picks the sample rate at boot, so the gates come up early
         //gate_in_1.Init((dsy_gpio_pin *)&TimeMachineHardware::B10);
         gate_in_1.Init((dsy_gpio_pin *)&B10);
         gate_in_2.Init((dsy_gpio_pin *)&B9);
+        boot.Mark("gates");
 
         /*
         gate_out_1.mode = DSY_GPIO_MODE_OUTPUT_PP;
@@ -418,7 +411,33 @@ namespace time_machine
 
         /** Start any background stuff */
         StartAdc();
+        boot.Mark("adc/controls");
+
         // StartDac();
+
+        if(!defer)
+            InitDeferred();
+    }
+
+    void TimeMachineHardware::InitDeferred()
+    {
+        /** QSPI isn't used by the firmware, so it doesn't hold up audio */
+        auto memory = System::GetProgramMemoryRegion();
+        if(memory != System::MemoryRegion::QSPI)
+        {
+            /** QUADSPI FLASH */
+            QSPIHandle::Config qspi_config;
+            qspi_config.device = QSPIHandle::Config::Device::IS25LP064A;
+            qspi_config.mode   = QSPIHandle::Config::Mode::MEMORY_MAPPED;
+            qspi_config.pin_config.io0 = {DSY_GPIOF, 8};
+            qspi_config.pin_config.io1 = {DSY_GPIOF, 9};
+            qspi_config.pin_config.io2 = {DSY_GPIOF, 7};
+            qspi_config.pin_config.io3 = {DSY_GPIOF, 6};
+            qspi_config.pin_config.clk = {DSY_GPIOF, 10};
+            qspi_config.pin_config.ncs = {DSY_GPIOG, 6};
+            qspi.Init(qspi_config);
+        }
+        boot.Mark("qspi");
     }
 
     void TimeMachineHardware::StartAudio(AudioHandle::AudioCallback cb)
@@ -448,10 +467,7 @@ namespace time_machine
     {
         audio.SetBlockSize(size);
         callback_rate_ = AudioSampleRate() / AudioBlockSize();
-        for(size_t i = 0; i < ADC_LAST; i++)
-        {
-            controls[i].SetSampleRate(callback_rate_);
-        }
+        UpdateControlRate();
     }
 
     void TimeMachineHardware::SetAudioSampleRate(float sr)
@@ -476,10 +492,7 @@ namespace time_machine
         }
         audio.SetSampleRate(sai_sr);
         callback_rate_ = AudioSampleRate() / AudioBlockSize();
-        for(size_t i = 0; i < ADC_LAST; i++)
-        {
-            controls[i].SetSampleRate(callback_rate_);
-        }
+        UpdateControlRate();
     }
 
     void
@@ -487,10 +500,7 @@ namespace time_machine
     {
         audio.SetSampleRate(sample_rate);
         callback_rate_ = AudioSampleRate() / AudioBlockSize();
-        for(size_t i = 0; i < ADC_LAST; i++)
-        {
-            controls[i].SetSampleRate(callback_rate_);
-        }
+        UpdateControlRate();
     }
 
     size_t TimeMachineHardware::AudioBlockSize()
@@ -502,6 +512,19 @@ namespace time_machine
 
     float TimeMachineHardware::AudioCallbackRate() { return callback_rate_; }
 
+    void TimeMachineHardware::SetControlDecimation(size_t n)
+    {
+        control_decimation_ = n > 0 ? n : 1;
+        UpdateControlRate();
+    }
+
+    void TimeMachineHardware::UpdateControlRate()
+    {
+        float rate = ControlRate();
+        for(size_t i = 0; i < ADC_LAST; i++)
+            controls[i].SetSampleRate(rate);
+    }
+
     void TimeMachineHardware::StartAdc() { adc.Start(); }
 
     void TimeMachineHardware::StopAdc() { adc.Stop(); }
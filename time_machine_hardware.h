@@ -2,6 +2,7 @@
 
 #include "daisy.h"
 #include "daisy_patch_sm.h"
+#include "boot_timeline.h"
 
 using namespace daisy;
 using namespace patch_sm;
@@ -86,8 +87,15 @@ namespace time_machine
         TimeMachineHardware() {}
         ~TimeMachineHardware() {}
 
-        /** Initializes the memories, and core peripherals for the Daisy Patch SM */
-        void Init();
+        /** Initializes the memories, and core peripherals for the Daisy Patch SM
+         *  \param defer if true, the peripherals audio doesn't need (QSPI)
+         *         are left for InitDeferred(), to be called once audio is
+         *         running.
+         */
+        void Init(bool defer = false);
+
+        /** Initializes what Init(true) skipped. Safe to call while audio runs. */
+        void InitDeferred();
 
         /** Starts a non-interleaving audio callback */
         void StartAudio(AudioHandle::AudioCallback cb);
@@ -154,6 +162,14 @@ namespace time_machine
             ProcessDigitalControls();
         }
 
+        /** Tunes the control filters for ProcessAllControls() being called
+         *  every n-th audio block rather than every block. Default 1.
+         */
+        void SetControlDecimation(size_t n);
+
+        /** Rate ProcessAllControls() is expected to run at, in Hz */
+        float ControlRate() { return callback_rate_ / control_decimation_; }
+
         /** Returns the current value for one of the ADCs */
         float GetAdcValue(int idx);
 
@@ -275,6 +291,9 @@ namespace time_machine
         Pcm3060     codec;
         DacHandle   dac;
 
+        /** Boot phase timestamps, filled in by Init() and the caller */
+        oam::BootTimeline boot;
+
         /** Dedicated Function Pins */
         dsy_gpio      user_led;
         AnalogControl controls[ADC_LAST];
@@ -298,6 +317,10 @@ namespace time_machine
         using Log = Logger<LOGGER_INTERNAL>;
 
         float callback_rate_;
+        size_t control_decimation_ = 1;
+
+        /** Retunes the control filters after a rate change */
+        void UpdateControlRate();
 
         /** Background callback for updating the DACs. */
         Impl* pimpl_;
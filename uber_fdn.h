@@ -1,86 +1,57 @@
 #pragma once
 #include "daisysp.h"
+#include "dry_wet.h"
+#include "dsp_profiler.h"
+#include "fast_math.h"
+#include "halfband.h"
+#include "ring_buffer.h"
 #include <cmath>
 
 using namespace daisysp;
 
 // Helper Classes
-class OmniDelay {
-public:
-  void Init(float *buf, int max) {
-    buffer_ = buf;
-    max_len_ = max;
-    write_ptr_ = 0;
-  }
-  void Write(float sample) {
-    buffer_[write_ptr_] = sample;
-    write_ptr_++;
-    if (write_ptr_ >= max_len_)
-      write_ptr_ = 0;
-  }
-  float Read(float delay_samps) {
-    // Linear Interpolation
-    float read_pos = (float)write_ptr_ - delay_samps;
-    while (read_pos < 0.0f)
-      read_pos += (float)max_len_;
-    while (read_pos >= (float)max_len_)
-      read_pos -= (float)max_len_;
-
-    int idx = (int)read_pos;
-    float frac = read_pos - idx;
-    int idx2 = idx + 1;
-    if (idx2 >= max_len_)
-      idx2 = 0;
-
-    return buffer_[idx] + frac * (buffer_[idx2] - buffer_[idx]);
-  }
-
-private:
-  float *buffer_;
-  int max_len_;
-  int write_ptr_;
-};
-
 class OmniAllpass {
 public:
+  // Room for the longest diffuser at 96 kHz
+  static constexpr int kMaxSamples = 2048;
+  static_assert(kMaxSamples == oam::RingSize(kMaxSamples),
+                "ring buffers are a power of two");
+
   void Init() {
-    for (int i = 0; i < 600; i++)
-      buffer_[i] = 0.0f;
-    write_ptr_ = 0;
+    ring_.Init(buffer_, kMaxSamples);
+    ring_.Clear();
     delay_len_ = 100;
   }
   void SetDelay(int len) {
     delay_len_ = len;
-    if (len > 599)
-      delay_len_ = 599;
+    if (len > kMaxSamples - 1)
+      delay_len_ = kMaxSamples - 1;
   }
   float Process(float in) {
-    int read_ptr = write_ptr_ - delay_len_;
-    if (read_ptr < 0)
-      read_ptr += 600;
-    float buf_out = buffer_[read_ptr];
+    float buf_out = ring_.Tap(delay_len_);
     float out = -in + buf_out;
-    buffer_[write_ptr_] = in + (0.5f * buf_out);
-    write_ptr_++;
-    if (write_ptr_ >= 600)
-      write_ptr_ = 0;
+    ring_.Write(in + (0.5f * buf_out));
     return out;
   }
 
 private:
-  float buffer_[600];
-  int write_ptr_;
-  int delay_len_;
+  float buffer_[kMaxSamples];
+  oam::RingBuffer<float> ring_;
+  uint32_t delay_len_;
 };
 
 class OmniOnePole {
 public:
-  void Init() {
+  void Init(float sample_rate) {
+    sample_rate_ = sample_rate;
     out_ = 0.0f;
     SetFreq(6000.0f);
   }
   void SetFreq(float freq) {
-    float b1 = expf(-2.0f * 3.1415927f * freq / 48000.0f);
+    SetCoefficient(oam::FastExp(-2.0f * 3.1415927f * freq / sample_rate_));
+  }
+  // b1 = exp(-2 pi fc / sr), for callers that precompute it
+  void SetCoefficient(float b1) {
     b1_ = b1;
     a0_ = 1.0f - b1;
   }
@@ -90,40 +61,139 @@ public:
   }
 
 private:
+  float sample_rate_;
   float a0_, b1_, out_;
 };
 
+// Bank of DaisySP-style Svf filters (same 2x oversampled Chamberlin core) with
+// the state laid out per field so the per-sample loop runs through all lines
+// in one pass. Frequencies are fixed at Init; the resonance coefficients are
+// only recomputed when a line's resonance moves by more than kResThreshold.
+template <int N> class OmniSvfBank {
+public:
+  static constexpr float kResThreshold = 0.001f;
+
+  void Init(float sample_rate, const float *freqs) {
+    for (int k = 0; k < N; k++) {
+      float fc = fminf(freqs[k], sample_rate / 3.0f);
+      freq_[k] =
+          2.0f *
+          oam::FastSin(3.1415927f * fminf(0.25f, fc / (sample_rate * 2.0f)));
+      res_[k] = -1.0f;
+      low_[k] = 0.0f;
+      band_[k] = 0.0f;
+      SetRes(k, 0.1f);
+    }
+  }
+
+  void SetRes(int k, float res) {
+    if (fabsf(res - res_[k]) <= kResThreshold)
+      return;
+    res = res < 0.0f ? 0.0f : (res > 1.0f ? 1.0f : res);
+    res_[k] = res;
+    damp_[k] = fminf(2.0f * (1.0f - oam::FastPow(res, 0.25f)),
+                     fminf(2.0f, 2.0f / freq_[k] - freq_[k] * 0.5f));
+    drive_[k] = 0.5f * res; // Svf default pre-drive of 0.5
+  }
+
+  // io[k] in, io[k] = low_gain * Low() + band_gain * Band() out
+  void Process(float *io, float low_gain, float band_gain) {
+    for (int k = 0; k < N; k++) {
+      float in = io[k];
+      float f = freq_[k], d = damp_[k], drv = drive_[k];
+      float low = low_[k], band = band_[k];
+
+      low += f * band;
+      float high = in - d * band - low;
+      band = f * high + band - drv * band * band * band;
+      float out_low = low, out_band = band;
+
+      low += f * band;
+      high = in - d * band - low;
+      band = f * high + band - drv * band * band * band;
+      out_low += low;
+      out_band += band;
+
+      low_[k] = low;
+      band_[k] = band;
+      io[k] = 0.5f * (low_gain * out_low + band_gain * out_band);
+    }
+  }
+
+private:
+  float freq_[N], damp_[N], drive_[N], res_[N];
+  float low_[N], band_[N];
+};
+
 enum FdnMode { MODE_STUDIO, MODE_SHIMMER, MODE_MASSIVE };
 
+// The feedback network runs at the audio rate by default. Build with
+// FDN_HALF_RATE=1 (OAM_FDN_HALF_RATE) to run it at half the rate between a
+// half-band decimator and interpolator: the damping keeps the tails under
+// 10 kHz anyway, the network costs about half the CPU, and the same delay
+// memory holds twice the time. The wet path loses everything above 9 kHz
+// (0.1875 of the audio rate) and gains 22 samples of latency; dry is
+// untouched.
+#ifdef OAM_FDN_HALF_RATE
+static constexpr int kFdnRateDiv = 2;
+#else
+static constexpr int kFdnRateDiv = 1;
+#endif
+
 template <int N_LINES = 8> class UberFDN {
 public:
+  // Every length below is a time, converted to samples at Init(). The
+  // delay line length, rounded up to a power of two, caps the longest
+  // line; kMaxLineSeconds leaves room for the modulation on top of it. At
+  // half rate both double.
+  static constexpr float kLineSeconds = 5.0f;
+  static constexpr float kMaxLineSeconds = 4.79f;
+
+  // Floats Init() takes from big_buffer at `sr`
+  static constexpr size_t MemorySamples(float sr) {
+    return (size_t)N_LINES * LineSamples(sr);
+  }
+
   void Init(float sample_rate, float *big_buffer) {
+    // Everything below runs at the network's rate
+    const float audio_rate = sample_rate;
+    sample_rate = audio_rate / (float)kFdnRateDiv;
     sample_rate_ = sample_rate;
+    dry_wet_.Reset();
     // manually assign chunks
-    for (int i = 0; i < N_LINES; i++) {
-      // 240,000 floats each
-      delays_[i].Init(&big_buffer[i * 240000], 240000);
-    }
-    mode_ = MODE_STUDIO;
-
-    int diff_lens[4] = {225, 341, 441, 556};
+    const size_t line_samples = LineSamples(audio_rate);
+    for (int i = 0; i < N_LINES; i++)
+      delays_[i].Init(&big_buffer[i * line_samples], line_samples);
+    max_line_t_ = kMaxLineSeconds * audio_rate;
+
+    decimator_.Reset();
+    interp_l_.Reset();
+    interp_r_.Reset();
+    half_in_ = half_l_ = half_r_ = 0.0f;
+    half_odd_ = false;
+
+    // 225, 341, 441 and 556 samples at 48 kHz
+    const float diff_ms[4] = {4.6875f, 7.1042f, 9.1875f, 11.5833f};
     for (int i = 0; i < 4; i++) {
       diffusers_[i].Init();
-      diffusers_[i].SetDelay(diff_lens[i]);
+      diffusers_[i].SetDelay((int)(diff_ms[i] * 0.001f * sample_rate + 0.5f));
     }
 
-    // Init Shimmers
+    // Init Shimmers, 33 ms grains
     for (int i = 0; i < 2; i++) {
       shimmers_[i].Init(sample_rate);
       shimmers_[i].SetTransposition(12.0f);
-      shimmers_[i].SetDelSize(1600);
+      shimmers_[i].SetDelSize((uint32_t)(sample_rate / 30.0f + 0.5f));
     }
 
+    // Line modulation depth, 10 and 100 samples at 48 kHz
+    rate_scale_ = sample_rate / 48000.0f;
+
     // Init Modulators & Filters
+    float res_freqs[N_LINES];
     for (int i = 0; i < N_LINES; i++) {
       // LFO for Studio/Shimmer
       lfo_[i].Init(sample_rate);
-      lfo_[i].SetWaveform(Oscillator::WAVE_SIN);
       lfo_[i].SetAmp(1.0f);
       lfo_[i].SetFreq(0.1f + (i * 0.05f));
 
@@ -136,29 +206,123 @@ public:
       wander2_[i].SetAmp(0.3f);
 
       // Damping (OnePole for Studio/Shimmer)
-      damp_lpf_[i].Init();
+      damp_lpf_[i].Init(sample_rate);
+      damp_gain_[i] = -1.0f;
+
+      // Octaves. At half rate OmniSvfBank clamps the top one (10.24 kHz)
+      // to a third of the network rate, 8 kHz at 48 kHz audio
+      res_freqs[i] = 80.0f * (float)(1 << i);
+    }
+    // Resonators (SVF for Massive)
+    resonators_.Init(sample_rate, res_freqs);
 
-      // Resonators (SVF for Massive)
-      resonators_[i].Init(sample_rate);
-      resonators_[i].SetRes(0.1f);
+    // Damping cutoff (2k..10k over the slider range) -> one-pole coefficient
+    for (int i = 0; i <= kDampTableSize; i++) {
+      float co = kDampMinHz + (kDampRangeHz * i / (float)kDampTableSize);
+      damp_table_[i] = oam::FastExp(-2.0f * 3.1415927f * co / sample_rate_);
     }
 
     master_decay_ = 0.5f;
+    times_valid_ = false;
+    ratio_skew_ = -1.0f;
   }
 
   void SetMode(FdnMode m) { mode_ = m; }
 
+  // Writes the final dry/wet mix, dry_mix ramps over the block. S is the
+  // step between frames: 1 for separate channel buffers, 2 for interleaved
+  // L/R frames (in_r == in_l + 1, out_r == out_l + 1).
+  template <size_t S = 1>
   void ProcessBlock(const float *in_l, const float *in_r, float *out_l,
                     float *out_r, size_t size, const float *gains,
-                    float size_param, float skew, float warp) {
+                    float size_param, float skew, float warp, float dry_mix) {
+    // One dispatch per block; each mode gets its own branch-free kernel
+    dry_wet_.Begin(dry_mix, size);
+    switch (mode_) {
+    case MODE_SHIMMER:
+      ProcessBlockMode<MODE_SHIMMER, S>(in_l, in_r, out_l, out_r, size, gains,
+                                     size_param, skew, warp);
+      break;
+    case MODE_MASSIVE:
+      ProcessBlockMode<MODE_MASSIVE, S>(in_l, in_r, out_l, out_r, size, gains,
+                                     size_param, skew, warp);
+      break;
+    default:
+      ProcessBlockMode<MODE_STUDIO, S>(in_l, in_r, out_l, out_r, size, gains,
+                                    size_param, skew, warp);
+      break;
+    }
+  }
+
+  void SetDecay(float d) { master_decay_ = d; }
+
+private:
+  // Block constants for Tick()
+  struct BlockParams {
+    float depth;     // line modulation, samples
+    float shift_mix; // Massive pitch shift
+    float inject;    // input into the lines
+    float fb[N_LINES];
+    float time_inc[N_LINES]; // line time step per tick
+  };
+
+  static constexpr size_t LineSamples(float sr) {
+    return oam::RingSize((size_t)(kLineSeconds * sr));
+  }
+
+  float sample_rate_; // the network's rate, audio rate / kFdnRateDiv
+  oam::DryWetRamp dry_wet_;
+  oam::RingBuffer<float> delays_[N_LINES];
+  OmniAllpass diffusers_[4];
+
+  // Shared LFOs? No, keep separate for character
+  oam::SineLfo lfo_[N_LINES];
+  oam::SineLfo wander1_[N_LINES];
+  oam::SineLfo wander2_[N_LINES];
+
+  static constexpr int kDampTableSize = 64;
+  static constexpr float kDampMinHz = 2000.0f;
+  static constexpr float kDampRangeHz = 8000.0f;
+  OmniOnePole damp_lpf_[N_LINES];
+  float damp_gain_[N_LINES]; // slider value the coefficient was set for
+  float damp_table_[kDampTableSize + 1];
+  OmniSvfBank<N_LINES> resonators_;
+
+  PitchShifter shimmers_[2];
+
+  float master_decay_;
+  float line_t_[N_LINES]; // base delay per line at the end of the last block
+  bool times_valid_;
+  float max_line_t_;          // kMaxLineSeconds in samples
+  float rate_scale_;          // sample rate / 48 kHz
+  float line_ratio_[N_LINES]; // base_ratios_[k]^(0.5 + skew)
+  float ratio_skew_;          // skew line_ratio_ was computed for
+  FdnMode mode_ = MODE_STUDIO; // set before Init by main()
+
+  const float base_ratios_[8] = {1.000f, 1.137f, 1.289f, 1.458f,
+                                 1.632f, 1.815f, 2.053f, 2.311f};
+
+  // Half-rate resampling. A pair of audio samples makes one tick: the
+  // first waits in half_in_, the second runs the tick, whose interpolated
+  // output is a pair too; its second sample waits in half_l_/half_r_ and
+  // comes out on the next first sample. Pairs can straddle blocks.
+  oam::HalfbandDecimator decimator_;
+  oam::HalfbandInterpolator interp_l_, interp_r_;
+  float half_in_, half_l_, half_r_;
+  bool half_odd_; // next sample completes a pair
+
+  template <FdnMode M, size_t S>
+  void ProcessBlockMode(const float *in_l, const float *in_r, float *out_l,
+                        float *out_r, size_t size, const float *gains,
+                        float size_param, float skew, float warp) {
+    BlockParams p;
     // Parameter setup based on mode
-    float depth = 10.0f;
-    if (mode_ == MODE_MASSIVE)
-      depth = 100.0f; // Massive drift
+    p.depth =
+        (M == MODE_MASSIVE ? 100.0f : 10.0f) * rate_scale_; // Massive drift
 
     // Shimmer Setup
-    float shift_mix = 0.0f;
-    if (mode_ == MODE_SHIMMER) {
+    p.shift_mix = 0.0f;
+    if (M == MODE_SHIMMER) {
       // Sliders 7 & 8 control shimmer mix indirectly via code logic?
       // In Shimmer mode, sliders control feedback. We apply shimmer fixed on
       // lines 6/7. Let's hardcode effect for now or use Warp knob? Original
@@ -166,137 +330,180 @@ public:
       // Fixed behavior.
       shimmers_[0].SetTransposition(12.0f);
       shimmers_[1].SetTransposition(12.0f);
-      shift_mix = 1.0f; // Always active on specific lines
-    } else if (mode_ == MODE_MASSIVE) {
+    } else if (M == MODE_MASSIVE) {
+      for (int k = 0; k < N_LINES; k++)
+        resonators_.SetRes(k, 0.1f + (gains[k] * 0.7f));
+
       // Massive logic from before
       if (warp > 0.6f) {
-        shift_mix = (warp - 0.6f) * 2.5f;
+        p.shift_mix = (warp - 0.6f) * 2.5f;
         shimmers_[0].SetTransposition(warp > 0.85f ? 19.0f : 12.0f);
         shimmers_[1].SetTransposition(warp > 0.85f ? 19.02f : 12.02f);
       } else {
         // Detune only
         shimmers_[0].SetTransposition((warp - 0.2f) * 2.0f);
         shimmers_[1].SetTransposition((warp - 0.2f) * 2.0f + 0.02f);
-        shift_mix = (warp < 0.4f) ? 0.5f : 0.0f;
+        p.shift_mix = (warp < 0.4f) ? 0.5f : 0.0f;
       }
     }
-
-    for (size_t i = 0; i < size; i++) {
-      float input = (in_l[i] + in_r[i]) * 0.5f;
-      float diffused = input;
-
-      // Diffusion
-      for (int k = 0; k < 4; k++)
-        diffused = diffusers_[k].Process(diffused);
-
-      // Read
-      float delay_outs[N_LINES];
+    if (M != MODE_MASSIVE) {
       for (int k = 0; k < N_LINES; k++) {
-        // Mod
-        float mod_val = 0.0f;
-        if (mode_ == MODE_MASSIVE) {
-          mod_val = wander1_[k].Process() + wander2_[k].Process();
-        } else {
-          mod_val = lfo_[k].Process();
+        if (gains[k] != damp_gain_[k]) {
+          damp_gain_[k] = gains[k];
+          damp_lpf_[k].SetCoefficient(DampCoefficient(gains[k]));
         }
-
-        // Delay Time
-        float ratio = base_ratios_[k];
-        float s = powf(ratio, 0.5f + skew);
-        float base_t = s * size_param * sample_rate_ * 0.15f;
-        if (base_t > 230000)
-          base_t = 230000;
-
-        float final_t = base_t + (mod_val * depth);
-        delay_outs[k] = delays_[k].Read(final_t);
       }
+    }
 
-      // Mix
-      float sum = 0.0f;
-      for (int k = 0; k < N_LINES; k++)
-        sum += delay_outs[k];
-      sum *= 0.25f;
+    // Feedback gains and input injection. The main loop can't change the
+    // sliders or the decay mid-block, so these are block constants too.
+    // Massive freezes (unity feedback, no new input) above 0.98 decay.
+    const bool freeze = M == MODE_MASSIVE && master_decay_ > 0.98f;
+    p.inject = freeze ? 0.0f : 0.25f;
+    for (int k = 0; k < N_LINES; k++) {
+      p.fb[k] = gains[k] * master_decay_;
+      if (p.fb[k] > 0.99f)
+        p.fb[k] = 0.99f;
+      if (freeze)
+        p.fb[k] = 1.0f;
+    }
 
-      float matrix_out[N_LINES];
+    // Delay Times: size and skew only move once per block, so each line
+    // ramps linearly to its new length over the block's ticks (at half
+    // rate, the pairs completed in it). The pow only runs when the skew
+    // changes, short blocks don't pay it every time.
+    if (skew != ratio_skew_) {
+      ratio_skew_ = skew;
       for (int k = 0; k < N_LINES; k++)
-        matrix_out[k] = delay_outs[k] - sum;
-
-      // Feedback
-      for (int k = 0; k < N_LINES; k++) {
-        float fb = gains[k] * master_decay_;
-        if (fb > 0.99f)
-          fb = 0.99f;
-        if (mode_ == MODE_MASSIVE && master_decay_ > 0.98f)
-          fb = 1.0f;
-
-        float next = matrix_out[k] * fb;
-        if (mode_ != MODE_MASSIVE || master_decay_ <= 0.98f)
-          next += diffused * 0.25f;
-
-        // Tone Shaping
-        if (mode_ == MODE_MASSIVE) {
-          float freq = 80.0f * powf(2.0f, k); // Octaves
-          resonators_[k].SetFreq(freq);
-          resonators_[k].SetRes(0.1f + (gains[k] * 0.7f));
-          resonators_[k].Process(next);
-          next = (resonators_[k].Low() * 0.5f) + (resonators_[k].Band() * 0.8f);
-        } else {
-          // Studio/Shimmer uses LPF
-          float co = 2000.0f + (gains[k] * 8000.0f);
-          damp_lpf_[k].SetFreq(co);
-          next = damp_lpf_[k].Process(next);
-        }
-
-        // Shimmer Logic
-        if (mode_ == MODE_SHIMMER) {
-          if (k == 6 || k == 7) {
-            float s = shimmers_[k - 6].Process(next);
-            // Mix 50/50
-            next = (next * 0.5f) + (s * 0.5f);
-          }
-        } else if (mode_ == MODE_MASSIVE && shift_mix > 0.0f) {
-          if (k == 3)
-            next = (next * (1.0f - shift_mix)) +
-                   (shimmers_[0].Process(next) * shift_mix);
-          if (k == 7)
-            next = (next * (1.0f - shift_mix)) +
-                   (shimmers_[1].Process(next) * shift_mix);
-        }
+        line_ratio_[k] = oam::FastPow(base_ratios_[k], 0.5f + skew);
+    }
+    const size_t ticks =
+        kFdnRateDiv == 1 ? size : (size + (half_odd_ ? 1 : 0)) / 2;
+    float target_t[N_LINES];
+    for (int k = 0; k < N_LINES; k++) {
+      float t = line_ratio_[k] * size_param * sample_rate_ * 0.15f;
+      if (t > max_line_t_)
+        t = max_line_t_;
+      target_t[k] = t;
+      if (!times_valid_)
+        line_t_[k] = t;
+      p.time_inc[k] = ticks > 0 ? (t - line_t_[k]) / (float)ticks : 0.0f;
+    }
+    times_valid_ = true;
 
-        next = SoftLimit(next);
-        delays_[k].Write(next);
+    for (size_t i = 0; i < size; i++) {
+      float input = (in_l[i * S] + in_r[i * S]) * 0.5f;
+      float l, r;
+      if (kFdnRateDiv == 1) {
+        Tick<M>(input, p, l, r);
+      } else if (!half_odd_) {
+        half_in_ = input;
+        l = half_l_;
+        r = half_r_;
+      } else {
+        float tick_l, tick_r;
+        Tick<M>(decimator_.Process(half_in_, input), p, tick_l, tick_r);
+        interp_l_.Process(tick_l, l, half_l_);
+        interp_r_.Process(tick_r, r, half_r_);
       }
+      half_odd_ = kFdnRateDiv == 2 && !half_odd_;
 
-      // Output
-      float l = delay_outs[0] - delay_outs[2] + delay_outs[4] - delay_outs[6];
-      float r = delay_outs[1] - delay_outs[3] + delay_outs[5] - delay_outs[7];
-      out_l[i] = l * 0.25f;
-      out_r[i] = r * 0.25f;
+      float dry = dry_wet_.Next();
+      out_l[i * S] = (l * 0.25f) * (1.0f - dry) + in_l[i * S] * dry;
+      out_r[i * S] = (r * 0.25f) * (1.0f - dry) + in_r[i * S] * dry;
+      OAM_PROF_MARK(oam::PROF_MIX);
     }
-  }
-
-  void SetDecay(float d) { master_decay_ = d; }
 
-private:
-  float sample_rate_;
-  OmniDelay delays_[N_LINES];
-  OmniAllpass diffusers_[4];
+    // Land exactly on the targets so rounding can't accumulate across blocks
+    for (int k = 0; k < N_LINES; k++)
+      line_t_[k] = target_t[k];
+  }
 
-  // Shared LFOs? No, keep separate for character
-  Oscillator lfo_[N_LINES];
-  Oscillator wander1_[N_LINES];
-  Oscillator wander2_[N_LINES];
+  // One step of the network: `input` in, the unscaled L/R taps out
+  template <FdnMode M>
+  inline void Tick(float input, const BlockParams &p, float &l, float &r) {
+    float diffused = input;
+
+    // Diffusion
+    for (int k = 0; k < 4; k++)
+      diffused = diffusers_[k].Process(diffused);
+    OAM_PROF_MARK(oam::PROF_DIFFUSION);
+
+    // Read
+    float delay_outs[N_LINES];
+    for (int k = 0; k < N_LINES; k++) {
+      // Mod
+      float mod_val;
+      if (M == MODE_MASSIVE)
+        mod_val = wander1_[k].Process() + wander2_[k].Process();
+      else
+        mod_val = lfo_[k].Process();
+
+      line_t_[k] += p.time_inc[k];
+      float final_t = line_t_[k] + (mod_val * p.depth);
+      delay_outs[k] = delays_[k].Read(final_t);
+    }
+    OAM_PROF_MARK(oam::PROF_DELAY_READ);
+
+    // Mix
+    float sum = 0.0f;
+    for (int k = 0; k < N_LINES; k++)
+      sum += delay_outs[k];
+    sum *= 0.25f;
+
+    float matrix_out[N_LINES];
+    for (int k = 0; k < N_LINES; k++)
+      matrix_out[k] = delay_outs[k] - sum;
+    OAM_PROF_MARK(oam::PROF_MATRIX);
+
+    // Feedback
+    float next[N_LINES];
+    for (int k = 0; k < N_LINES; k++)
+      next[k] = matrix_out[k] * p.fb[k] + diffused * p.inject;
+
+    // Tone Shaping
+    if (M == MODE_MASSIVE) {
+      resonators_.Process(next, 0.5f, 0.8f);
+    } else {
+      // Studio/Shimmer uses LPF, coefficients set per block above
+      for (int k = 0; k < N_LINES; k++)
+        next[k] = damp_lpf_[k].Process(next[k]);
+    }
 
-  OmniOnePole damp_lpf_[N_LINES];
-  Svf resonators_[N_LINES];
+    // Shimmer Logic
+    if (M == MODE_SHIMMER) {
+      // Always active on lines 6/7, mix 50/50
+      next[6] = (next[6] * 0.5f) + (shimmers_[0].Process(next[6]) * 0.5f);
+      next[7] = (next[7] * 0.5f) + (shimmers_[1].Process(next[7]) * 0.5f);
+    } else if (M == MODE_MASSIVE && p.shift_mix > 0.0f) {
+      next[3] = (next[3] * (1.0f - p.shift_mix)) +
+                (shimmers_[0].Process(next[3]) * p.shift_mix);
+      next[7] = (next[7] * (1.0f - p.shift_mix)) +
+                (shimmers_[1].Process(next[7]) * p.shift_mix);
+    }
 
-  PitchShifter shimmers_[2];
+    for (int k = 0; k < N_LINES; k++)
+      delays_[k].Write(SoftLimit(next[k]));
+    OAM_PROF_MARK(oam::PROF_FEEDBACK);
 
-  float master_decay_;
-  FdnMode mode_;
+    // Output
+    l = delay_outs[0] - delay_outs[2] + delay_outs[4] - delay_outs[6];
+    r = delay_outs[1] - delay_outs[3] + delay_outs[5] - delay_outs[7];
+  }
 
-  const float base_ratios_[8] = {1.000f, 1.137f, 1.289f, 1.458f,
-                                 1.632f, 1.815f, 2.053f, 2.311f};
+  // Linear lookup of the damping coefficient for a 0..1 slider value
+  float DampCoefficient(float gain) const {
+    float pos = gain * kDampTableSize;
+    if (pos < 0.0f)
+      pos = 0.0f;
+    if (pos > (float)kDampTableSize)
+      pos = (float)kDampTableSize;
+    int idx = (int)pos;
+    if (idx >= kDampTableSize)
+      idx = kDampTableSize - 1;
+    float frac = pos - idx;
+    return damp_table_[idx] + frac * (damp_table_[idx + 1] - damp_table_[idx]);
+  }
 
   float SoftLimit(float x) {
     return x * (27.0f + x * x) / (27.0f + 9.0f * x * x);